@@ -0,0 +1,128 @@
+/// @file bench.h
+/// @brief Tiny helpers shared by the benchmark programs in `bench/`.
+///
+/// The benchmarks are plain executables without a framework.  Each one times
+/// a workload with bench_now_ns() and prints one line per measurement via
+/// bench_report().  Build them in Release mode (`just release`) for numbers
+/// that mean anything.
+
+// Inclusion guard
+#ifndef HELLOC_BENCH_H
+#define HELLOC_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/// @brief Returns a timestamp in nanoseconds for measuring elapsed time.
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+/// @brief Prevents the compiler from optimizing away the computation of v.
+static inline void bench_keep(uint64_t v) {
+    // A volatile sink is portable, unlike inline assembly barriers.
+    static volatile uint64_t sink;
+    sink = v;
+    (void)sink;
+}
+
+/// @brief Returns the next number of a xorshift64 pseudo-random sequence.
+///
+/// @param[in,out] state The generator state.  Must be non-zero.
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/// @brief Prints the time per operation for a measured workload.
+///
+/// @param[in] name The name of the data structure or function under test.
+/// @param[in] op The name of the operation, e.g., "append".
+/// @param[in] n The number of operations performed.
+/// @param[in] elapsed_ns The total elapsed time in nanoseconds.
+static inline void bench_report(const char *name, const char *op, uint64_t n,
+                                uint64_t elapsed_ns) {
+    double per_op = n > 0 ? (double)elapsed_ns / (double)n : 0.0;
+    printf("%-20s %-16s n=%-10llu %10.2f ns/op\n", name, op,
+           (unsigned long long)n, per_op);
+}
+
+/// Number of linear sub-buckets per power of two in a BenchHistogram.
+#define BENCH_HISTOGRAM_SUB_BUCKETS 8
+
+/// @brief A log-linear histogram of latencies in nanoseconds.
+///
+/// Values are grouped by their highest set bit, and each power of two is split
+/// into BENCH_HISTOGRAM_SUB_BUCKETS linear sub-buckets, so the relative error
+/// of a reported percentile is at most 12.5%.  A zero-initialized histogram is
+/// empty.
+typedef struct {
+    uint64_t counts[64 * BENCH_HISTOGRAM_SUB_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} BenchHistogram;
+
+static inline size_t bench_histogram_bucket(uint64_t v) {
+    if (v < BENCH_HISTOGRAM_SUB_BUCKETS) {
+        return (size_t)v;
+    }
+    const unsigned msb = 63U - (unsigned)__builtin_clzll(v);
+    const unsigned sub = (unsigned)(v >> (msb - 3U)) & 7U;
+    return ((size_t)(msb - 2U) * BENCH_HISTOGRAM_SUB_BUCKETS) + sub;
+}
+
+// Returns the smallest value that maps to the given bucket.
+static inline uint64_t bench_histogram_bucket_floor(size_t bucket) {
+    if (bucket < BENCH_HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    const unsigned msb = (unsigned)(bucket / BENCH_HISTOGRAM_SUB_BUCKETS) + 2U;
+    const uint64_t sub = bucket % BENCH_HISTOGRAM_SUB_BUCKETS;
+    return (uint64_t)(BENCH_HISTOGRAM_SUB_BUCKETS + sub) << (msb - 3U);
+}
+
+/// @brief Records one latency sample.
+static inline void bench_histogram_add(BenchHistogram *h, uint64_t ns) {
+    h->counts[bench_histogram_bucket(ns)]++;
+    h->total++;
+    if (ns > h->max) {
+        h->max = ns;
+    }
+}
+
+/// @brief Returns the approximate latency at the given percentile.
+///
+/// @param[in] h The histogram.
+/// @param[in] p The percentile in the range [0, 100], e.g. 99.0.
+static inline uint64_t bench_histogram_percentile(const BenchHistogram *h,
+                                                  double p) {
+    const double rank = (p / 100.0) * (double)h->total;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < 64 * BENCH_HISTOGRAM_SUB_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > 0 && (double)seen >= rank) {
+            return bench_histogram_bucket_floor(i);
+        }
+    }
+    return h->max;
+}
+
+/// @brief Prints the p50, p99, p99.9 and maximum latencies of a histogram.
+static inline void bench_report_latency(const char *name, const char *op,
+                                        const BenchHistogram *h) {
+    printf("%-20s %-16s p50=%llu p99=%llu p99.9=%llu max=%llu ns\n", name, op,
+           (unsigned long long)bench_histogram_percentile(h, 50.0),
+           (unsigned long long)bench_histogram_percentile(h, 99.0),
+           (unsigned long long)bench_histogram_percentile(h, 99.9),
+           (unsigned long long)h->max);
+}
+
+#endif // HELLOC_BENCH_H
@@ -0,0 +1,149 @@
+/// @file builder-bench.c
+/// @brief Compares the helloc string builder with building strings by
+/// strcat().
+///
+/// Usage: `builder-bench [rows]` (default: 100000)
+///
+/// Each benchmark builds a CSV-like report with one row per iteration, such
+/// as "row42,-42,0.42\n", from a name, an integer and a formatted number:
+///
+/// * `strcat`: appends every piece with strcat(), which rescans the report
+///   built so far, so the time per row grows with the number of rows.  Only
+///   the first STRCAT_MAX_ROWS rows are built, since this is quadratic.
+/// * `builder`: appends to a HellocBuilder that allocates from the heap.
+/// * `builder arena`: the same with a HellocBuilder in an arena.
+///
+/// Then it compares two ways to write rows with large BLOB_SIZE payloads to
+/// /dev/null, flushing every FLUSH_ROWS rows:
+///
+/// * `copy`: helloc_builder_append() copies each payload into the buffer.
+/// * `ref`: helloc_builder_append_ref() only references each payload, and
+///   helloc_builder_flush() writes it from its own memory with writev().
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_arena.h"
+#include "helloc_builder.h"
+
+enum {
+    DEFAULT_ROWS = 100000,
+    STRCAT_MAX_ROWS = 20000,
+    // Bytes per row in the worst case, for sizing the strcat() buffer and the
+    // arena.
+    MAX_ROW_LEN = 64,
+    BLOB_SIZE = 4096,
+    BLOB_ROWS = 16,
+    FLUSH_ROWS = 64
+};
+
+static void bench_strcat(size rows) {
+    const size n = rows < STRCAT_MAX_ROWS ? rows : STRCAT_MAX_ROWS;
+    char *report = malloc((size_t)(n * MAX_ROW_LEN) + 1);
+    if (report == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    report[0] = '\0';
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        char piece[MAX_ROW_LEN];
+        snprintf(piece, sizeof(piece), "row%td", i);
+        strcat(report, piece);
+        strcat(report, ",");
+        snprintf(piece, sizeof(piece), "%td", -i);
+        strcat(report, piece);
+        snprintf(piece, sizeof(piece), ",%.2f\n", (double)i / 100.0);
+        strcat(report, piece);
+    }
+    bench_report("strcat", "row", (uint64_t)n, bench_now_ns() - start);
+    bench_keep(strlen(report));
+    free(report);
+}
+
+static void bench_builder(const char *name, size rows, HellocArena *arena) {
+    HellocBuilder b;
+    helloc_builder_init(&b, arena);
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < rows; i++) {
+        const bool ok =
+            helloc_builder_appendf(&b, "row%td", i) == E_SUCCESS &&
+            helloc_builder_append(&b, s8(",")) == E_SUCCESS &&
+            helloc_builder_append_i64(&b, -i) == E_SUCCESS &&
+            helloc_builder_appendf(&b, ",%.2f\n", (double)i / 100.0) ==
+                E_SUCCESS;
+        if (!ok) {
+            fprintf(stderr, "%s: append failed\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    bench_report(name, "row", (uint64_t)rows, bench_now_ns() - start);
+    bench_keep((uint64_t)helloc_builder_len(&b));
+    helloc_builder_free(&b);
+}
+
+static void bench_flush(const char *name, size rows, bool by_ref, int fd,
+                        s8 *blobs) {
+    HellocBuilder b;
+    helloc_builder_init(&b, nullptr);
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < rows; i++) {
+        const s8 blob = blobs[i % BLOB_ROWS];
+        const bool ok =
+            helloc_builder_append_i64(&b, i) == E_SUCCESS &&
+            helloc_builder_append(&b, s8(":")) == E_SUCCESS &&
+            (by_ref ? helloc_builder_append_ref(&b, blob)
+                    : helloc_builder_append(&b, blob)) == E_SUCCESS &&
+            ((i + 1) % FLUSH_ROWS != 0 ||
+             helloc_builder_flush(&b, fd) == E_SUCCESS);
+        if (!ok) {
+            fprintf(stderr, "%s: append or flush failed\n", name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (helloc_builder_flush(&b, fd) != E_SUCCESS) {
+        exit(EXIT_FAILURE);
+    }
+    bench_report(name, "row+flush", (uint64_t)rows, bench_now_ns() - start);
+    helloc_builder_free(&b);
+}
+
+int main(int argc, char **argv) {
+    const size rows =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_ROWS;
+    if (rows <= 0) {
+        fprintf(stderr, "usage: %s [rows > 0]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("--- %td rows ---\n", rows);
+    bench_strcat(rows);
+    bench_builder("builder", rows, nullptr);
+    HellocArena arena;
+    if (helloc_arena_init(&arena, rows * MAX_ROW_LEN * 2) != E_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    bench_builder("builder arena", rows, &arena);
+    helloc_arena_free(&arena);
+
+    const int fd = open("/dev/null", O_WRONLY);
+    u8 *payload = malloc((size_t)BLOB_SIZE * BLOB_ROWS);
+    if (fd < 0 || payload == nullptr) {
+        return EXIT_FAILURE;
+    }
+    s8 blobs[BLOB_ROWS];
+    for (size i = 0; i < BLOB_ROWS; i++) {
+        memset(payload + (i * BLOB_SIZE), 'a' + (int)i, BLOB_SIZE);
+        blobs[i] = (s8){payload + (i * BLOB_SIZE), BLOB_SIZE};
+    }
+    bench_flush("copy", rows, false, fd, blobs);
+    bench_flush("ref", rows, true, fd, blobs);
+    free(payload);
+    close(fd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/// @file ingest-bench.c
+/// @brief Compares reading many small files serially with
+/// helloc_ingest_files().
+///
+/// Usage: `ingest-bench [files] [file_size] [queue_depth]` (default: 20000
+/// files of 4096 bytes, queue depth 32)
+///
+/// Creates the files in a temporary directory and reads all of them with:
+///
+/// * `serial`: open(), read() and close() one file after another, like a
+///   simple loop over the paths.
+/// * `pread pool`: helloc_ingest_files() with `force_pread`, i.e., a pool of
+///   `queue_depth` threads.
+/// * `io_uring`: helloc_ingest_files() with up to `queue_depth` files in
+///   flight in one io_uring.  Reported as `io_uring (n/a)` if the kernel does
+///   not support it and the pread() fallback ran instead.
+///
+/// The files were just written, so they are in the page cache and the numbers
+/// show the syscall and scheduling overhead per file.  As root, run
+/// `echo 3 > /proc/sys/vm/drop_caches` between runs to include the disk.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_ingest.h"
+
+enum {
+    DEFAULT_FILES = 20000,
+    DEFAULT_FILE_SIZE = 4096,
+    DEFAULT_QUEUE_DEPTH = 32,
+    PATH_LEN = 64
+};
+
+// Keeps the callback cheap, since helloc_ingest_files() runs it serially:
+// only the lengths and the first byte of every chunk are summed up.
+static void sum_chunk(void *ctx, const HellocIngestChunk *chunk) {
+    u64 *sum = ctx;
+    if (chunk->data.len > 0) {
+        *sum += (u64)chunk->data.len + chunk->data.data[0];
+    }
+}
+
+static void bench_serial(const char *const *paths, size n, size file_size) {
+    u8 *buf = malloc((size_t)file_size);
+    if (buf == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    u64 sum = 0;
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        const int fd = open(paths[i], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "%s: %s\n", paths[i], strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        ssize_t r;
+        while ((r = read(fd, buf, (size_t)file_size)) > 0) {
+            const HellocIngestChunk chunk = {.file = i, .data = {buf, r}};
+            sum_chunk(&sum, &chunk);
+        }
+        close(fd);
+    }
+    bench_report("serial", "file", (uint64_t)n, bench_now_ns() - start);
+    bench_keep(sum);
+    free(buf);
+}
+
+static void bench_ingest(const char *name, const char *const *paths, size n,
+                         size file_size, int queue_depth, bool force_pread) {
+    const HellocIngestOptions opts = {.queue_depth = queue_depth,
+                                      .buffer_size = file_size,
+                                      .force_pread = force_pread};
+    u64 sum = 0;
+    HellocIngestStats stats;
+    const uint64_t start = bench_now_ns();
+    const Result res =
+        helloc_ingest_files(paths, n, &opts, sum_chunk, &sum, &stats);
+    const uint64_t elapsed = bench_now_ns() - start;
+    if (res != E_SUCCESS || stats.files_failed > 0) {
+        fprintf(stderr, "%s: ingestion failed\n", name);
+        exit(EXIT_FAILURE);
+    }
+    if (!force_pread && stats.backend != HELLOC_INGEST_IO_URING) {
+        name = "io_uring (n/a)";
+    }
+    bench_report(name, "file", (uint64_t)n, elapsed);
+    bench_keep(sum);
+}
+
+int main(int argc, char **argv) {
+    const size n =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_FILES;
+    const size file_size =
+        argc > 2 ? (size)strtoll(argv[2], nullptr, 10) : DEFAULT_FILE_SIZE;
+    const int queue_depth =
+        argc > 3 ? (int)strtol(argv[3], nullptr, 10) : DEFAULT_QUEUE_DEPTH;
+    if (n <= 0 || file_size <= 0 || queue_depth <= 0) {
+        fprintf(stderr, "usage: %s [files > 0] [file_size > 0] "
+                        "[queue_depth > 0]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char dir[] = "/tmp/helloc-ingest-XXXXXX";
+    char *names = malloc((size_t)(n * PATH_LEN));
+    const char **paths = malloc((size_t)n * sizeof(*paths));
+    u8 *content = malloc((size_t)file_size);
+    if (mkdtemp(dir) == nullptr || names == nullptr || paths == nullptr ||
+        content == nullptr) {
+        return EXIT_FAILURE;
+    }
+    u64 rng = 42;
+    for (size i = 0; i < file_size; i++) {
+        content[i] = (u8)bench_rand(&rng);
+    }
+    for (size i = 0; i < n; i++) {
+        char *name = names + (i * PATH_LEN);
+        snprintf(name, PATH_LEN, "%s/%td", dir, i);
+        paths[i] = name;
+        const int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0 || write(fd, content, (size_t)file_size) != file_size) {
+            fprintf(stderr, "%s: %s\n", name, strerror(errno));
+            return EXIT_FAILURE;
+        }
+        close(fd);
+    }
+
+    printf("--- %td files of %td bytes, queue depth %d ---\n", n, file_size,
+           queue_depth);
+    bench_serial(paths, n, file_size);
+    bench_ingest("pread pool", paths, n, file_size, queue_depth, true);
+    bench_ingest("io_uring", paths, n, file_size, queue_depth, false);
+
+    for (size i = 0; i < n; i++) {
+        unlink(paths[i]);
+    }
+    rmdir(dir);
+    free(content);
+    free(paths);
+    free(names);
+    return EXIT_SUCCESS;
+}
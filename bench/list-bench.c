@@ -0,0 +1,201 @@
+/// @file list-bench.c
+/// @brief Compares the helloc unrolled list with zpl_list and stb_ds arrays.
+///
+/// Usage: `list-bench [num_items]` (default: 1000000)
+///
+/// Measures appending items, traversing all items, and inserting items at
+/// random positions in the middle of the sequence.  The items are s8 strings
+/// in all three cases:
+///
+/// * `helloc_ulist`: unrolled list, 62 items per 1 KiB node.
+/// * `zpl_list`: doubly-linked list, one heap-allocated node per item.
+/// * `stb_ds arr`: dynamic array, i.e. one contiguous buffer.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZPL_IMPLEMENTATION
+#define ZPL_NANO
+#include "zpl.h"
+
+#define STB_DS_IMPLEMENTATION
+#include "stb_ds.h"
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_ulist.h"
+
+enum { DEFAULT_NUM_ITEMS = 1000000, TRAVERSALS = 10, MIDDLE_INSERTS = 100 };
+
+static const char *const kWords[] = {
+    "alpha", "bravo",    "charlie", "delta",   "echo", "foxtrot",
+    "golf",  "hotel",    "india",   "juliett", "kilo", "lima",
+    "mike",  "november", "oscar",   "papa",
+};
+static s8 g_words[COUNTOF(kWords)];
+
+static void init_words(void) {
+    for (size i = 0; i < COUNTOF(kWords); i++) {
+        g_words[i] = (s8){(u8 *)kWords[i], (size)strlen(kWords[i])};
+    }
+}
+
+static s8 word(size i) { return g_words[i % COUNTOF(g_words)]; }
+
+// A zpl_list node together with the item it points to, allocated in one go.
+typedef struct {
+    zpl_list link;
+    s8 item;
+} ZplItem;
+
+static void bench_ulist(size n) {
+    HellocUList l;
+    helloc_ulist_init(&l);
+
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        if (helloc_ulist_append(&l, word(i)) != E_SUCCESS) {
+            fprintf(stderr, "helloc_ulist_append failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    bench_report("helloc_ulist", "append", (uint64_t)n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    uint64_t total = 0;
+    for (int t = 0; t < TRAVERSALS; t++) {
+        for (const HellocUListNode *node = l.head; node != nullptr;
+             node = node->next) {
+            for (size i = 0; i < node->count; i++) {
+                total += (uint64_t)node->items[i].len;
+            }
+        }
+    }
+    bench_keep(total);
+    bench_report("helloc_ulist", "traverse", (uint64_t)n * TRAVERSALS,
+                 bench_now_ns() - start);
+
+    uint64_t rng = 42;
+    start = bench_now_ns();
+    for (int i = 0; i < MIDDLE_INSERTS; i++) {
+        size at = (size)(bench_rand(&rng) % (uint64_t)l.len);
+        if (helloc_ulist_insert(&l, at, word(at)) != E_SUCCESS) {
+            fprintf(stderr, "helloc_ulist_insert failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    bench_report("helloc_ulist", "insert-middle", MIDDLE_INSERTS,
+                 bench_now_ns() - start);
+
+    helloc_ulist_free(&l);
+}
+
+static void bench_zpl_list(size n) {
+    zpl_list *head = nullptr;
+    zpl_list *tail = nullptr;
+
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        ZplItem *it = malloc(sizeof(*it));
+        if (it == nullptr) {
+            fprintf(stderr, "malloc failed\n");
+            exit(EXIT_FAILURE);
+        }
+        it->item = word(i);
+        zpl_list_init(&it->link, &it->item);
+        if (tail == nullptr) {
+            head = tail = &it->link;
+        } else {
+            tail = zpl_list_add(tail, &it->link);
+        }
+    }
+    bench_report("zpl_list", "append", (uint64_t)n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    uint64_t total = 0;
+    for (int t = 0; t < TRAVERSALS; t++) {
+        for (zpl_list *l = head; l != nullptr; l = l->next) {
+            total += (uint64_t)((const s8 *)l->ptr)->len;
+        }
+    }
+    bench_keep(total);
+    bench_report("zpl_list", "traverse", (uint64_t)n * TRAVERSALS,
+                 bench_now_ns() - start);
+
+    uint64_t rng = 42;
+    size len = n;
+    start = bench_now_ns();
+    for (int i = 0; i < MIDDLE_INSERTS; i++) {
+        size at = (size)(bench_rand(&rng) % (uint64_t)len);
+        zpl_list *cursor = head;
+        for (size j = 0; j < at; j++) {
+            cursor = cursor->next;
+        }
+        ZplItem *it = malloc(sizeof(*it));
+        if (it == nullptr) {
+            fprintf(stderr, "malloc failed\n");
+            exit(EXIT_FAILURE);
+        }
+        it->item = word(at);
+        zpl_list_init(&it->link, &it->item);
+        zpl_list_add(cursor, &it->link);
+        len++;
+    }
+    bench_report("zpl_list", "insert-middle", MIDDLE_INSERTS,
+                 bench_now_ns() - start);
+
+    // The link is the first member of ZplItem, so the node is the allocation.
+    zpl_list *l = head;
+    while (l != nullptr) {
+        zpl_list *next = l->next;
+        free(l);
+        l = next;
+    }
+}
+
+static void bench_stb_arr(size n) {
+    s8 *arr = nullptr;
+
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        arrput(arr, word(i));
+    }
+    bench_report("stb_ds arr", "append", (uint64_t)n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    uint64_t total = 0;
+    for (int t = 0; t < TRAVERSALS; t++) {
+        for (size_t i = 0; i < arrlenu(arr); i++) {
+            total += (uint64_t)arr[i].len;
+        }
+    }
+    bench_keep(total);
+    bench_report("stb_ds arr", "traverse", (uint64_t)n * TRAVERSALS,
+                 bench_now_ns() - start);
+
+    uint64_t rng = 42;
+    start = bench_now_ns();
+    for (int i = 0; i < MIDDLE_INSERTS; i++) {
+        size at = (size)(bench_rand(&rng) % (uint64_t)arrlenu(arr));
+        arrins(arr, at, word(at));
+    }
+    bench_report("stb_ds arr", "insert-middle", MIDDLE_INSERTS,
+                 bench_now_ns() - start);
+
+    arrfree(arr);
+}
+
+int main(int argc, char **argv) {
+    size n = argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_NUM_ITEMS;
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [num_items]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    init_words();
+    bench_ulist(n);
+    bench_zpl_list(n);
+    bench_stb_arr(n);
+    return EXIT_SUCCESS;
+}
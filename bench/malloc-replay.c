@@ -0,0 +1,658 @@
+/// @file malloc-replay.c
+/// @brief Replays an allocation trace against different allocators.
+///
+/// Usage: `malloc-replay <trace> [allocator...]` (default: all allocators)
+///
+/// Record a trace of any program with the LD_PRELOAD shim of
+/// `examples/malloc-trace.c`, e.g.:
+///
+/// ```
+/// $ export HELLOC_MALLOC_TRACE=/tmp/ls.trace
+/// $ LD_PRELOAD=build/examples/Release/libmalloc-trace.so ls -l
+/// $ malloc-replay /tmp/ls.trace glibc
+/// ```
+///
+/// The trace is decoded once into a list of operations on allocation ids, so
+/// that replaying it does not depend on the addresses of the traced process.
+/// Every allocator then runs the whole trace three times, each time in a
+/// fresh child process so that it starts with an empty heap:
+///
+/// * `replay`: the time of the whole replay divided by the number of
+///   operations.
+/// * `memory`: the peak RSS growth over the replay (sampled from
+///   /proc/self/statm) compared to the peak of the live bytes that the trace
+///   requested.  The allocator writes one byte per page of each new
+///   allocation, like a program that uses its memory.  The ratio of the two
+///   is the overhead caused by fragmentation and allocator metadata.
+/// * `malloc`, `calloc`, `realloc`, `free`: the latency distribution of each
+///   operation type.  Each operation is timed individually, so the values
+///   include the overhead of reading the clock.
+///
+/// The allocators under test are:
+///
+/// * `glibc`: the malloc() family of the C library.
+/// * `tutorial`: my_malloc() and my_free() of `examples/malloc-tutorial.c`.
+///   It has no realloc(), so realloc is emulated with malloc, memcpy and free.
+///   Its my_malloc() searches all blocks, so it is slow for large traces.
+/// * `pool`: one HellocPool (see helloc_pool.h) per size class of
+///   POOL_CLASS_SIZE bytes up to POOL_MAX_SIZE, and malloc() for larger
+///   sizes.  A header of POOL_HEADER bytes in front of each allocation stores
+///   its size class, because free() is not passed the size.
+/// * `arena`: one HellocArena (see helloc_arena.h) that is large enough for
+///   all allocations of the trace.  free() is a no-op, and realloc()
+///   allocates a new block and copies the data, so the peak RSS shows the
+///   worst case of an arena, which never reuses memory.  A header of
+///   POOL_HEADER bytes stores the size for realloc().
+///
+/// Add an allocator by adding an entry to kAllocators.
+///
+/// NOTE: Configure the build with `ENABLE_ASAN=OFF`, because with ASan the
+/// `glibc` allocator is in fact ASan's allocator.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_arena.h"
+#include "helloc_map.h"
+#include "helloc_pool.h"
+#include "malloc-trace.h"
+#include "malloc-tutorial.h"
+
+enum {
+    // Sample the RSS after this many operations in the `memory` pass.
+    RSS_SAMPLE_INTERVAL = 4096,
+    PAGE_SIZE_FALLBACK = 4096,
+    // Size classes of the `pool` allocator.  The header keeps the alignment
+    // of malloc().
+    POOL_CLASS_SIZE = 16,
+    POOL_MAX_SIZE = 1024,
+    POOL_HEADER = 16
+};
+
+typedef enum {
+    REPLAY_MALLOC,
+    REPLAY_CALLOC,
+    REPLAY_REALLOC,
+    REPLAY_FREE,
+    REPLAY_OP_KINDS
+} ReplayOpKind;
+
+static const char *const kOpNames[REPLAY_OP_KINDS] = {"malloc", "calloc",
+                                                      "realloc", "free"};
+
+/// One decoded operation.  `id` is the allocation that is created or freed;
+/// a realloc frees `id` and creates `new_id`.
+typedef struct {
+    ReplayOpKind kind;
+    size id;
+    size new_id;
+    size_t size;
+} ReplayOp;
+
+typedef struct {
+    ReplayOp *ops;
+    size len;
+    size cap;
+    /// Number of allocation ids, i.e., of successful malloc, calloc and
+    /// realloc calls.
+    size ids;
+    /// The requested size of each allocation id.
+    size_t *id_size;
+    size id_cap;
+    /// Peak sum of the requested sizes of all live allocations.
+    size_t peak_live;
+    /// Sum of the requested sizes of all allocations, i.e., the memory that
+    /// an allocator needs that never reuses memory.
+    size_t total_bytes;
+    /// Frees of pointers that the trace has not allocated, e.g. memory from
+    /// posix_memalign() or from before the shim was loaded.
+    size skipped;
+} ReplayTrace;
+
+/// An allocator under test.  calloc and realloc may be NULL, in which case
+/// they are emulated with malloc, memset, memcpy and free.
+typedef struct {
+    const char *name;
+    void *(*malloc)(size_t);
+    void *(*calloc)(size_t, size_t);
+    void *(*realloc)(void *, size_t);
+    void (*free)(void *);
+} Allocator;
+
+// The pools of the `pool` allocator, which are created on first use in the
+// child process of each pass.
+static HellocPool g_pools[POOL_MAX_SIZE / POOL_CLASS_SIZE];
+static bool g_pools_ready;
+
+static void *pooled_malloc(size_t n) {
+    if (!g_pools_ready) {
+        for (size i = 0; i < COUNTOF(g_pools); i++) {
+            const size obj_size = ((i + 1) * POOL_CLASS_SIZE) + POOL_HEADER;
+            if (helloc_pool_init(&g_pools[i], obj_size, POOL_HEADER) !=
+                E_SUCCESS) {
+                return nullptr;
+            }
+        }
+        g_pools_ready = true;
+    }
+    size_t cls = n > 0 ? (n - 1) / POOL_CLASS_SIZE : 0;
+    u8 *p;
+    if (cls < (size_t)COUNTOF(g_pools)) {
+        p = helloc_pool_alloc(&g_pools[cls]);
+    } else {
+        p = n <= SIZE_MAX - POOL_HEADER ? malloc(n + POOL_HEADER) : nullptr;
+        cls = SIZE_MAX;
+    }
+    if (p == nullptr) {
+        return nullptr;
+    }
+    memcpy(p, &cls, sizeof(cls));
+    return p + POOL_HEADER;
+}
+
+static void pooled_free(void *ptr);
+
+// Keeps the allocation if the new size has the same size class.
+static void *pooled_realloc(void *ptr, size_t n) {
+    if (ptr == nullptr) {
+        return pooled_malloc(n);
+    }
+    size_t cls;
+    memcpy(&cls, (u8 *)ptr - POOL_HEADER, sizeof(cls));
+    const size_t new_cls = n > 0 ? (n - 1) / POOL_CLASS_SIZE : 0;
+    const bool large = new_cls >= (size_t)COUNTOF(g_pools);
+    if (cls == SIZE_MAX && large) {
+        u8 *p = n <= SIZE_MAX - POOL_HEADER
+                    ? realloc((u8 *)ptr - POOL_HEADER, n + POOL_HEADER)
+                    : nullptr;
+        return p != nullptr ? p + POOL_HEADER : nullptr;
+    }
+    if (cls == new_cls) {
+        return ptr;
+    }
+    void *q = pooled_malloc(n);
+    if (q != nullptr) {
+        // One of the sizes is that of a pool, and the other one is larger.
+        const size_t old = cls != SIZE_MAX ? (cls + 1) * POOL_CLASS_SIZE : n;
+        memcpy(q, ptr, old < n ? old : n);
+        pooled_free(ptr);
+    }
+    return q;
+}
+
+static void pooled_free(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    u8 *p = (u8 *)ptr - POOL_HEADER;
+    size_t cls;
+    memcpy(&cls, p, sizeof(cls));
+    if (cls == SIZE_MAX) {
+        free(p);
+    } else {
+        helloc_pool_release(&g_pools[cls], p);
+    }
+}
+
+// The arena of the `arena` allocator, which is created on first use in the
+// child process of each pass with a capacity of g_arena_cap bytes.
+static HellocArena g_arena;
+static size g_arena_cap;
+
+static void *arena_malloc(size_t n) {
+    if (g_arena.mem == nullptr &&
+        helloc_arena_init(&g_arena, g_arena_cap) != E_SUCCESS) {
+        return nullptr;
+    }
+    if (n > (size_t)(PTRDIFF_MAX - POOL_HEADER)) {
+        return nullptr;
+    }
+    // The arena zeroes the memory, so arena_calloc() needs no memset().
+    u8 *p = helloc_arena_alloc(&g_arena, 1, POOL_HEADER,
+                               (size)n + POOL_HEADER);
+    if (p == nullptr) {
+        return nullptr;
+    }
+    memcpy(p, &n, sizeof(n));
+    return p + POOL_HEADER;
+}
+
+static void *arena_calloc(size_t count, size_t n) {
+    return count == 0 || n <= SIZE_MAX / count ? arena_malloc(count * n)
+                                               : nullptr;
+}
+
+// Never resizes in place, and keeps the old block.
+static void *arena_realloc(void *ptr, size_t n) {
+    void *q = arena_malloc(n);
+    if (ptr != nullptr && q != nullptr) {
+        size_t old;
+        memcpy(&old, (u8 *)ptr - POOL_HEADER, sizeof(old));
+        memcpy(q, ptr, old < n ? old : n);
+    }
+    return q;
+}
+
+static void arena_free(void *ptr) { (void)ptr; }
+
+static const Allocator kAllocators[] = {
+    {"glibc", malloc, calloc, realloc, free},
+    {"tutorial", my_malloc, nullptr, nullptr, my_free},
+    {"pool", pooled_malloc, nullptr, pooled_realloc, pooled_free},
+    {"arena", arena_malloc, arena_calloc, arena_realloc, arena_free},
+};
+
+static void *grow_array(void *p, size *cap, size_t elem_size) {
+    *cap = *cap > 0 ? 2 * *cap : 1024;
+    p = realloc(p, (size_t)*cap * elem_size);
+    if (p == nullptr) {
+        fprintf(stderr, "out of memory while decoding the trace\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static void trace_push(ReplayTrace *t, ReplayOp op) {
+    if (t->len == t->cap) {
+        t->ops = grow_array(t->ops, &t->cap, sizeof(*t->ops));
+    }
+    t->ops[t->len++] = op;
+}
+
+// Assigns a new allocation id to the address and returns it.
+static size trace_new_id(ReplayTrace *t, HellocMap *live, uint64_t addr,
+                         size_t n, size_t *live_bytes) {
+    if (t->ids == t->id_cap) {
+        t->id_size = grow_array(t->id_size, &t->id_cap, sizeof(*t->id_size));
+    }
+    const size id = t->ids++;
+    t->id_size[id] = n;
+    t->total_bytes += n;
+    *live_bytes += n;
+    if (*live_bytes > t->peak_live) {
+        t->peak_live = *live_bytes;
+    }
+    const s8 key = {(u8 *)&addr, sizeof(addr)};
+    if (helloc_map_put(live, key, (void *)(uptr)id) != E_SUCCESS) {
+        fprintf(stderr, "out of memory while decoding the trace\n");
+        exit(EXIT_FAILURE);
+    }
+    return id;
+}
+
+// Removes the address from the live allocations.  Returns its id, or -1 if
+// the address is unknown.
+static size trace_end_id(ReplayTrace *t, HellocMap *live, uint64_t addr,
+                         size_t *live_bytes) {
+    const s8 key = {(u8 *)&addr, sizeof(addr)};
+    void *value = nullptr;
+    if (!helloc_map_remove(live, key, &value)) {
+        return -1;
+    }
+    const size id = (size)(uptr)value;
+    *live_bytes -= t->id_size[id];
+    return id;
+}
+
+// Reads the next zigzag-encoded address delta.
+static int get_addr(const u8 **p, const u8 *end, uint64_t *addr) {
+    uint64_t v = 0;
+    if (malloc_trace_get_varint(p, end, &v) != 0) {
+        return -1;
+    }
+    *addr += (uint64_t)malloc_trace_unzigzag(v);
+    return 0;
+}
+
+static int decode(ReplayTrace *t, const u8 *p, const u8 *end) {
+    HellocMap live;
+    helloc_map_init(&live);
+    size_t live_bytes = 0;
+    uint64_t addr = 0;
+    while (p < end) {
+        const u8 op = *p++;
+        uint64_t n = 0;
+        uint64_t ptr = 0;
+        uint64_t result = 0;
+        switch (op) {
+        case MALLOC_TRACE_MALLOC:
+        case MALLOC_TRACE_CALLOC:
+            if (malloc_trace_get_varint(&p, end, &n) != 0 ||
+                get_addr(&p, end, &addr) != 0) {
+                goto truncated;
+            }
+            if (addr != 0) {
+                const size id =
+                    trace_new_id(t, &live, addr, (size_t)n, &live_bytes);
+                trace_push(t, (ReplayOp){op == MALLOC_TRACE_MALLOC
+                                             ? REPLAY_MALLOC
+                                             : REPLAY_CALLOC,
+                                         id, 0, (size_t)n});
+            }
+            break;
+        case MALLOC_TRACE_REALLOC: {
+            if (get_addr(&p, end, &addr) != 0) {
+                goto truncated;
+            }
+            ptr = addr;
+            if (malloc_trace_get_varint(&p, end, &n) != 0 ||
+                get_addr(&p, end, &addr) != 0) {
+                goto truncated;
+            }
+            result = addr;
+            if (result == 0 && n > 0) {
+                break; // failed realloc, the old allocation is unchanged
+            }
+            const size old_id =
+                ptr != 0 ? trace_end_id(t, &live, ptr, &live_bytes) : -1;
+            if (result == 0) { // realloc(ptr, 0) freed ptr
+                if (old_id >= 0) {
+                    trace_push(t, (ReplayOp){REPLAY_FREE, old_id, 0, 0});
+                }
+                break;
+            }
+            const size new_id =
+                trace_new_id(t, &live, result, (size_t)n, &live_bytes);
+            trace_push(t, old_id >= 0 ? (ReplayOp){REPLAY_REALLOC, old_id,
+                                                   new_id, (size_t)n}
+                                      : (ReplayOp){REPLAY_MALLOC, new_id, 0,
+                                                   (size_t)n});
+            break;
+        }
+        case MALLOC_TRACE_FREE: {
+            if (get_addr(&p, end, &addr) != 0) {
+                goto truncated;
+            }
+            const size id = trace_end_id(t, &live, addr, &live_bytes);
+            if (id >= 0) {
+                trace_push(t, (ReplayOp){REPLAY_FREE, id, 0, 0});
+            } else {
+                t->skipped++;
+            }
+            break;
+        }
+        default:
+            fprintf(stderr, "invalid op %u in trace\n", op);
+            helloc_map_free(&live);
+            return -1;
+        }
+    }
+    helloc_map_free(&live);
+    return 0;
+
+truncated:
+    // The traced process may have been killed before the shim flushed its
+    // buffer, so keep what was decoded so far.
+    fprintf(stderr, "warning: trace is truncated\n");
+    helloc_map_free(&live);
+    return 0;
+}
+
+static int load_trace(const char *path, ReplayTrace *t) {
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr) {
+        perror(path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    const long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *buf = file_size > 0 ? malloc((size_t)file_size) : nullptr;
+    if (buf == nullptr ||
+        fread(buf, 1, (size_t)file_size, f) != (size_t)file_size) {
+        fprintf(stderr, "%s: failed to read trace\n", path);
+        free(buf);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    MallocTraceHeader header;
+    if ((size_t)file_size < sizeof(header)) {
+        fprintf(stderr, "%s: not a malloc trace\n", path);
+        free(buf);
+        return -1;
+    }
+    memcpy(&header, buf, sizeof(header));
+    if (memcmp(header.magic, MALLOC_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MALLOC_TRACE_VERSION) {
+        fprintf(stderr, "%s: not a malloc trace of version %d\n", path,
+                MALLOC_TRACE_VERSION);
+        free(buf);
+        return -1;
+    }
+    const int rc = decode(t, buf + sizeof(header), buf + file_size);
+    free(buf);
+    return rc;
+}
+
+static void trace_free(ReplayTrace *t) {
+    free(t->ops);
+    free(t->id_size);
+    *t = (ReplayTrace){0};
+}
+
+static size_t rss_bytes(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    const int matched = fscanf(f, "%lu %lu", &pages, &resident);
+    fclose(f);
+    if (matched != 2) {
+        return 0;
+    }
+    const long page_size = sysconf(_SC_PAGESIZE);
+    return resident * (size_t)(page_size > 0 ? page_size : PAGE_SIZE_FALLBACK);
+}
+
+static void touch(void *p, size_t n) {
+    for (size_t i = 0; i < n; i += PAGE_SIZE_FALLBACK) {
+        ((volatile u8 *)p)[i] = 1;
+    }
+}
+
+// Runs one operation.  Returns the new allocation, if any.
+static inline void *run_op(const Allocator *a, const ReplayTrace *t,
+                           void **ptrs, const ReplayOp *op) {
+    void *p = nullptr;
+    switch (op->kind) {
+    case REPLAY_MALLOC:
+        p = a->malloc(op->size);
+        ptrs[op->id] = p;
+        break;
+    case REPLAY_CALLOC:
+        if (a->calloc != nullptr) {
+            p = a->calloc(1, op->size);
+        } else if ((p = a->malloc(op->size)) != nullptr) {
+            memset(p, 0, op->size);
+        }
+        ptrs[op->id] = p;
+        break;
+    case REPLAY_REALLOC:
+        if (a->realloc != nullptr) {
+            p = a->realloc(ptrs[op->id], op->size);
+        } else if ((p = a->malloc(op->size)) != nullptr) {
+            const size_t old = t->id_size[op->id];
+            if (ptrs[op->id] != nullptr) {
+                memcpy(p, ptrs[op->id], old < op->size ? old : op->size);
+            }
+            a->free(ptrs[op->id]);
+        }
+        ptrs[op->id] = nullptr;
+        ptrs[op->new_id] = p;
+        break;
+    case REPLAY_FREE:
+        a->free(ptrs[op->id]);
+        ptrs[op->id] = nullptr;
+        break;
+    case REPLAY_OP_KINDS:
+        break;
+    }
+    return p;
+}
+
+static void run_throughput(const Allocator *a, const ReplayTrace *t,
+                           void **ptrs) {
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < t->len; i++) {
+        run_op(a, t, ptrs, &t->ops[i]);
+    }
+    bench_report(a->name, "replay", (uint64_t)t->len, bench_now_ns() - start);
+}
+
+static void run_memory(const Allocator *a, const ReplayTrace *t,
+                       void **ptrs) {
+    const size_t base = rss_bytes();
+    size_t peak = base;
+    for (size i = 0; i < t->len; i++) {
+        void *p = run_op(a, t, ptrs, &t->ops[i]);
+        if (p != nullptr) {
+            touch(p, t->ops[i].size);
+        }
+        if (i % RSS_SAMPLE_INTERVAL == 0) {
+            const size_t rss = rss_bytes();
+            peak = rss > peak ? rss : peak;
+        }
+    }
+    // Catch peaks between the samples.
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0 &&
+        (size_t)usage.ru_maxrss * 1024 > peak) {
+        peak = (size_t)usage.ru_maxrss * 1024;
+    }
+    const size_t growth = peak - base;
+    printf("%-20s %-16s peak-rss=%zu KiB peak-live=%zu KiB overhead=%.2fx\n",
+           a->name, "memory", growth / 1024, t->peak_live / 1024,
+           t->peak_live > 0 ? (double)growth / (double)t->peak_live : 0.0);
+}
+
+static void run_latency(const Allocator *a, const ReplayTrace *t,
+                        void **ptrs) {
+    BenchHistogram *latency = calloc(REPLAY_OP_KINDS, sizeof(*latency));
+    if (latency == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    for (size i = 0; i < t->len; i++) {
+        const uint64_t t0 = bench_now_ns();
+        run_op(a, t, ptrs, &t->ops[i]);
+        bench_histogram_add(&latency[t->ops[i].kind], bench_now_ns() - t0);
+    }
+    for (int k = 0; k < REPLAY_OP_KINDS; k++) {
+        if (latency[k].total > 0) {
+            bench_report_latency(a->name, kOpNames[k], &latency[k]);
+        }
+    }
+    free(latency);
+}
+
+typedef void (*ReplayPass)(const Allocator *, const ReplayTrace *, void **);
+
+// Runs the pass in a child process, so that every pass starts with a fresh
+// heap and the allocations it leaks do not affect the next one.
+static int run_in_child(ReplayPass pass, const Allocator *a,
+                        const ReplayTrace *t) {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        // The id table is allocated with the C library and touched before
+        // the measurement, so that it is part of the baseline RSS.  The
+        // stores are volatile, because the compiler removes a memset() of
+        // memory that calloc() returns zeroed.
+        const size_t table_size = ((size_t)t->ids + 1) * sizeof(void *);
+        void **ptrs = calloc(1, table_size);
+        if (ptrs == nullptr) {
+            _exit(EXIT_FAILURE);
+        }
+        for (size_t off = 0; off < table_size; off += PAGE_SIZE_FALLBACK) {
+            ((volatile u8 *)ptrs)[off] = 0;
+        }
+        pass(a, t, ptrs);
+        fflush(stdout);
+        // Skip the exit handlers, the memory is reclaimed with the process.
+        _exit(EXIT_SUCCESS);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "%s: replay failed\n", a->name);
+        return -1;
+    }
+    return 0;
+}
+
+static const Allocator *find_allocator(const char *name) {
+    for (size i = 0; i < COUNTOF(kAllocators); i++) {
+        if (strcmp(kAllocators[i].name, name) == 0) {
+            return &kAllocators[i];
+        }
+    }
+    return nullptr;
+}
+
+static int replay(const Allocator *a, const ReplayTrace *t) {
+    if (run_in_child(run_throughput, a, t) != 0 ||
+        run_in_child(run_memory, a, t) != 0 ||
+        run_in_child(run_latency, a, t) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace> [allocator...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (find_allocator(argv[i]) == nullptr) {
+            fprintf(stderr, "unknown allocator '%s', available:", argv[i]);
+            for (size j = 0; j < COUNTOF(kAllocators); j++) {
+                fprintf(stderr, " %s", kAllocators[j].name);
+            }
+            fprintf(stderr, "\n");
+            return EXIT_FAILURE;
+        }
+    }
+#if defined(__SANITIZE_ADDRESS__)
+    fprintf(stderr, "warning: built with ASan, which replaces the glibc "
+                    "allocator; configure with ENABLE_ASAN=OFF\n");
+#endif
+
+    ReplayTrace t = {0};
+    if (load_trace(argv[1], &t) != 0) {
+        trace_free(&t);
+        return EXIT_FAILURE;
+    }
+    printf("--- %td ops, %td allocations, %td unknown frees skipped ---\n",
+           t.len, t.ids, t.skipped);
+    // Room for the header and the alignment of every allocation.
+    g_arena_cap = (size)t.total_bytes + ((t.ids + 1) * 2 * POOL_HEADER);
+
+    int rc = EXIT_SUCCESS;
+    if (argc == 2) {
+        for (size i = 0; i < COUNTOF(kAllocators); i++) {
+            rc |= replay(&kAllocators[i], &t) != 0 ? EXIT_FAILURE : 0;
+        }
+    } else {
+        for (int i = 2; i < argc; i++) {
+            rc |= replay(find_allocator(argv[i]), &t) != 0 ? EXIT_FAILURE : 0;
+        }
+    }
+    trace_free(&t);
+    return rc;
+}
@@ -0,0 +1,263 @@
+/// @file map-bench.c
+/// @brief Compares the helloc hash map with the stb_ds and zpl hash maps.
+///
+/// Usage: `map-bench [max_entries]` (default: 1000000)
+///
+/// Runs the benchmark for 1K, 10K, 100K, ... entries up to max_entries, e.g.
+/// `map-bench 100000000` for 100M entries.  That needs several GiB of RAM,
+/// because all keys are kept in memory up front.
+///
+/// For each map and size, it measures:
+///
+/// * `insert`: inserting all keys into an empty map, including any resizes.
+///   Each insert is timed individually to also report the latency
+///   distribution, which shows the pauses caused by resizing.  The mean
+///   includes the overhead of reading the clock.
+/// * `lookup-hit`: looking up every key that was inserted, in random order.
+/// * `lookup-miss`: looking up the same number of keys that were never
+///   inserted.
+/// * `delete`: removing every key, in random order.  zpl_table removes
+///   entries in O(n), so only ZPL_MAX_DELETES keys are removed from it.
+///
+/// The maps under test are:
+///
+/// * `helloc_map`: see helloc_map.h.
+/// * `stb_ds sh`: stb_ds string hash map (`sh*`), which stores the key
+///   pointers without copying the keys.
+/// * `zpl_table`: zpl's hash table, which only supports u64 keys.  The string
+///   keys are hashed with zpl_murmur64() and only that hash is stored, i.e.
+///   the key strings are never compared and hash collisions go undetected.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZPL_IMPLEMENTATION
+#define ZPL_NANO
+#define ZPL_ENABLE_HASHING
+#include "zpl.h"
+
+#define STB_DS_IMPLEMENTATION
+#include "stb_ds.h"
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_map.h"
+
+enum {
+    DEFAULT_MAX_ENTRIES = 1000000,
+    MIN_ENTRIES = 1000,
+    ZPL_MAX_DELETES = 100
+};
+
+ZPL_TABLE(static, ZplMap, zpl_map_, void *)
+
+// The keys of one benchmark run, stored as NUL-terminated strings in a single
+// buffer so that they can be used both as s8 and as C strings.
+typedef struct {
+    char *buf;
+    s8 *hit;      // keys that are inserted, in insertion order
+    s8 *shuffled; // the same keys in random order
+    s8 *miss;     // keys that are never inserted
+    size n;
+} Keys;
+
+static Keys keys_new(size n) {
+    // "k" or "m", 16 hex digits, and the NUL terminator
+    const size max_key_len = 18;
+    Keys k = {
+        .buf = malloc((size_t)(2 * n * max_key_len)),
+        .hit = malloc((size_t)n * sizeof(s8)),
+        .shuffled = malloc((size_t)n * sizeof(s8)),
+        .miss = malloc((size_t)n * sizeof(s8)),
+        .n = n,
+    };
+    if (k.buf == nullptr || k.hit == nullptr || k.shuffled == nullptr ||
+        k.miss == nullptr) {
+        fprintf(stderr, "failed to allocate keys for n=%td\n", n);
+        exit(EXIT_FAILURE);
+    }
+    char *p = k.buf;
+    uint64_t rng = 0x12345678;
+    for (size i = 0; i < n; i++) {
+        // Random rather than sequential numbers, so that the keys do not
+        // share long common prefixes in insertion order.
+        const uint64_t r = bench_rand(&rng);
+        int len = snprintf(p, (size_t)max_key_len, "k%016" PRIx64, r);
+        k.hit[i] = (s8){(u8 *)p, len};
+        p += len + 1;
+        len = snprintf(p, (size_t)max_key_len, "m%016" PRIx64, r);
+        k.miss[i] = (s8){(u8 *)p, len};
+        p += len + 1;
+    }
+    // Fisher-Yates shuffle
+    memcpy(k.shuffled, k.hit, (size_t)n * sizeof(s8));
+    for (size i = n - 1; i > 0; i--) {
+        const size j = (size)(bench_rand(&rng) % (uint64_t)(i + 1));
+        const s8 tmp = k.shuffled[i];
+        k.shuffled[i] = k.shuffled[j];
+        k.shuffled[j] = tmp;
+    }
+    return k;
+}
+
+static void keys_free(Keys *k) {
+    free(k->buf);
+    free(k->hit);
+    free(k->shuffled);
+    free(k->miss);
+}
+
+static void bench_helloc_map(const Keys *k) {
+    const char *name = "helloc_map";
+    HellocMap m;
+    helloc_map_init(&m);
+
+    BenchHistogram *latency = calloc(1, sizeof(*latency));
+    if (latency == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        const uint64_t t0 = bench_now_ns();
+        if (helloc_map_put(&m, k->hit[i], k->hit[i].data) != E_SUCCESS) {
+            fprintf(stderr, "helloc_map_put failed\n");
+            exit(EXIT_FAILURE);
+        }
+        bench_histogram_add(latency, bench_now_ns() - t0);
+    }
+    bench_report(name, "insert", (uint64_t)k->n, bench_now_ns() - start);
+    bench_report_latency(name, "insert", latency);
+    free(latency);
+
+    uint64_t found = 0;
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += helloc_map_get(&m, k->shuffled[i], nullptr);
+    }
+    bench_report(name, "lookup-hit", (uint64_t)k->n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += helloc_map_get(&m, k->miss[i], nullptr);
+    }
+    bench_report(name, "lookup-miss", (uint64_t)k->n, bench_now_ns() - start);
+    bench_keep(found);
+
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        helloc_map_remove(&m, k->shuffled[i], nullptr);
+    }
+    bench_report(name, "delete", (uint64_t)k->n, bench_now_ns() - start);
+    helloc_map_free(&m);
+}
+
+static void bench_stb_sh(const Keys *k) {
+    const char *name = "stb_ds sh";
+    struct {
+        char *key;
+        void *value;
+    } *sh = nullptr;
+
+    BenchHistogram *latency = calloc(1, sizeof(*latency));
+    if (latency == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        const uint64_t t0 = bench_now_ns();
+        shput(sh, (char *)k->hit[i].data, k->hit[i].data);
+        bench_histogram_add(latency, bench_now_ns() - t0);
+    }
+    bench_report(name, "insert", (uint64_t)k->n, bench_now_ns() - start);
+    bench_report_latency(name, "insert", latency);
+    free(latency);
+
+    uint64_t found = 0;
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += shgeti(sh, (char *)k->shuffled[i].data) >= 0;
+    }
+    bench_report(name, "lookup-hit", (uint64_t)k->n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += shgeti(sh, (char *)k->miss[i].data) >= 0;
+    }
+    bench_report(name, "lookup-miss", (uint64_t)k->n, bench_now_ns() - start);
+    bench_keep(found);
+
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        shdel(sh, (char *)k->shuffled[i].data);
+    }
+    bench_report(name, "delete", (uint64_t)k->n, bench_now_ns() - start);
+    shfree(sh);
+}
+
+static void bench_zpl_table(const Keys *k) {
+    const char *name = "zpl_table";
+    ZplMap m;
+    zpl_map_init(&m, zpl_heap_allocator());
+
+    BenchHistogram *latency = calloc(1, sizeof(*latency));
+    if (latency == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        const uint64_t t0 = bench_now_ns();
+        zpl_map_set(&m, zpl_murmur64(k->hit[i].data, k->hit[i].len),
+                    k->hit[i].data);
+        bench_histogram_add(latency, bench_now_ns() - t0);
+    }
+    bench_report(name, "insert", (uint64_t)k->n, bench_now_ns() - start);
+    bench_report_latency(name, "insert", latency);
+    free(latency);
+
+    uint64_t found = 0;
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += zpl_map_get(&m, zpl_murmur64(k->shuffled[i].data,
+                                              k->shuffled[i].len)) != nullptr;
+    }
+    bench_report(name, "lookup-hit", (uint64_t)k->n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (size i = 0; i < k->n; i++) {
+        found += zpl_map_get(&m, zpl_murmur64(k->miss[i].data,
+                                              k->miss[i].len)) != nullptr;
+    }
+    bench_report(name, "lookup-miss", (uint64_t)k->n, bench_now_ns() - start);
+    bench_keep(found);
+
+    const size deletes = k->n < ZPL_MAX_DELETES ? k->n : ZPL_MAX_DELETES;
+    start = bench_now_ns();
+    for (size i = 0; i < deletes; i++) {
+        zpl_map_remove(&m,
+                       zpl_murmur64(k->shuffled[i].data, k->shuffled[i].len));
+    }
+    bench_report(name, "delete", (uint64_t)deletes, bench_now_ns() - start);
+    zpl_map_destroy(&m);
+}
+
+int main(int argc, char **argv) {
+    const size max_n =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_MAX_ENTRIES;
+    if (max_n < MIN_ENTRIES) {
+        fprintf(stderr, "usage: %s [max_entries >= %d]\n", argv[0],
+                MIN_ENTRIES);
+        return EXIT_FAILURE;
+    }
+    for (size n = MIN_ENTRIES; n <= max_n; n *= 10) {
+        printf("--- %td entries ---\n", n);
+        Keys k = keys_new(n);
+        bench_helloc_map(&k);
+        bench_stb_sh(&k);
+        bench_zpl_table(&k);
+        keys_free(&k);
+    }
+    return EXIT_SUCCESS;
+}
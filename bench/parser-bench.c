@@ -0,0 +1,113 @@
+/// @file parser-bench.c
+/// @brief Compares the streaming record parser with splitting NUL-terminated
+/// copies of the records.
+///
+/// Usage: `parser-bench [records]` (default: 1000000)
+///
+/// Generates a stream of "key<i>=value<i>\n" records in memory and parses it
+/// with:
+///
+/// * `str_split_once`: copies each record to a NUL-terminated string, as
+///   helloc_str_split_once() requires, and splits it into two new strings.
+/// * `parser <n>`: feeds the stream to a HellocParser in chunks of n bytes,
+///   as they would come from read().  Only the records that span chunks are
+///   copied.  Also prints the capacity of the carry buffer, which is all the
+///   memory the parser needs, however long the stream.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_parser.h"
+
+enum { DEFAULT_RECORDS = 1000000, MAX_RECORD_LEN = 64 };
+
+static void count_record(void *ctx, const HellocRecord *record) {
+    u64 *sum = ctx;
+    *sum += (u64)record->key.len + (u64)record->value.len;
+}
+
+static void bench_str_split(s8 stream, size records) {
+    u64 sum = 0;
+    const uint64_t start = bench_now_ns();
+    s8 rest = stream;
+    while (rest.len > 0) {
+        const u8 *nl = memchr(rest.data, '\n', (size_t)rest.len);
+        const size len = nl != nullptr ? nl - rest.data : rest.len;
+        char line[MAX_RECORD_LEN];
+        memcpy(line, rest.data, (size_t)len);
+        line[len] = '\0';
+        char *key = nullptr;
+        char *value = nullptr;
+        if (helloc_str_split_once(line, '=', &key, &value) != E_SUCCESS) {
+            exit(EXIT_FAILURE);
+        }
+        sum += strlen(key) + strlen(value);
+        free(key);
+        free(value);
+        rest.data += len + 1;
+        rest.len -= len + 1;
+    }
+    bench_report("str_split_once", "record", (uint64_t)records,
+                 bench_now_ns() - start);
+    bench_keep(sum);
+}
+
+static void bench_parser(s8 stream, size records, size chunk_size) {
+    u64 sum = 0;
+    HellocParser p;
+    if (helloc_parser_init(&p, s8("\n"), '=', 0, count_record, &sum) !=
+        E_SUCCESS) {
+        exit(EXIT_FAILURE);
+    }
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < stream.len; i += chunk_size) {
+        const size n =
+            stream.len - i < chunk_size ? stream.len - i : chunk_size;
+        if (helloc_parser_feed(&p, (s8){stream.data + i, n}) != E_SUCCESS) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    helloc_parser_finish(&p);
+    const uint64_t elapsed = bench_now_ns() - start;
+    if (p.records != records) {
+        fprintf(stderr, "parser: %td of %td records\n", p.records, records);
+        exit(EXIT_FAILURE);
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "parser %td", chunk_size);
+    bench_report(name, "record", (uint64_t)records, elapsed);
+    printf("%-20s carry buffer: %td bytes\n", name, p.carry_cap);
+    bench_keep(sum);
+    helloc_parser_free(&p);
+}
+
+int main(int argc, char **argv) {
+    const size records =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_RECORDS;
+    if (records <= 0) {
+        fprintf(stderr, "usage: %s [records > 0]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    u8 *data = malloc((size_t)(records * MAX_RECORD_LEN));
+    if (data == nullptr) {
+        return EXIT_FAILURE;
+    }
+    s8 stream = {data, 0};
+    for (size i = 0; i < records; i++) {
+        stream.len += snprintf((char *)data + stream.len, MAX_RECORD_LEN,
+                               "key%td=value%td\n", i, i * 7);
+    }
+
+    printf("--- %td records, %td bytes ---\n", records, stream.len);
+    bench_str_split(stream, records);
+    bench_parser(stream, records, 4096);
+    bench_parser(stream, records, 64 * 1024);
+    bench_parser(stream, records, stream.len);
+    free(data);
+    return EXIT_SUCCESS;
+}
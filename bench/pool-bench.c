@@ -0,0 +1,184 @@
+/// @file pool-bench.c
+/// @brief Compares the helloc pool allocator with malloc() and free() for
+/// objects of one size.
+///
+/// Usage: `pool-bench [objects] [threads]` (default: 1000000 objects, 4
+/// threads)
+///
+/// Each benchmark allocates and releases 32-byte objects:
+///
+/// * `pair`: allocates an object and releases it right away, so the same
+///   memory is reused, which is the best case of any allocator.
+/// * `batch`: allocates all objects, then releases them in a shuffled order,
+///   like a list or a tree that is built and torn down.
+/// * `threads`: every thread runs `batch` with objects / threads objects at
+///   the same time, which shows the contention on the shared state.
+///
+/// Finally, `reset` releases all objects of a batch with one
+/// helloc_pool_reset() call instead of one release per object.
+///
+/// Each measurement follows an untimed warm-up run, so that it neither
+/// includes the first touch of the memory nor the time that glibc spends on
+/// consolidating the chunks that the previous benchmark has freed.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "helloc_pool.h"
+
+enum { DEFAULT_OBJECTS = 1000000, DEFAULT_THREADS = 4, OBJECT_SIZE = 32 };
+
+static HellocPool g_pool;
+
+static void *alloc_pool(void) { return helloc_pool_alloc(&g_pool); }
+static void release_pool(void *p) { helloc_pool_release(&g_pool, p); }
+static void *alloc_malloc(void) { return malloc(OBJECT_SIZE); }
+
+typedef struct {
+    const char *name;
+    void *(*alloc)(void);
+    void (*release)(void *);
+} Allocator;
+
+static const Allocator kAllocators[] = {
+    {"malloc", alloc_malloc, free},
+    {"pool", alloc_pool, release_pool},
+};
+
+typedef struct {
+    const Allocator *a;
+    void **objs;
+    size n;
+    u64 seed;
+} BatchArgs;
+
+static void shuffle(void **objs, size n, u64 seed) {
+    for (size i = n - 1; i > 0; i--) {
+        const size j = (size)(bench_rand(&seed) % (u64)(i + 1));
+        void *t = objs[i];
+        objs[i] = objs[j];
+        objs[j] = t;
+    }
+}
+
+// Allocates the objects and releases them in a shuffled order.  The shuffle
+// is not timed.  Returns the elapsed time in nanoseconds.
+static uint64_t run_batch(const BatchArgs *args) {
+    uint64_t start = bench_now_ns();
+    for (size i = 0; i < args->n; i++) {
+        args->objs[i] = args->a->alloc();
+        *(size *)args->objs[i] = i;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    shuffle(args->objs, args->n, args->seed);
+    start = bench_now_ns();
+    for (size i = 0; i < args->n; i++) {
+        args->a->release(args->objs[i]);
+    }
+    return elapsed + (bench_now_ns() - start);
+}
+
+static void *batch_thread(void *arg) {
+    run_batch(arg);
+    return nullptr;
+}
+
+static void bench_pair(const Allocator *a, size n) {
+    a->release(a->alloc());
+    const uint64_t start = bench_now_ns();
+    for (size i = 0; i < n; i++) {
+        void *p = a->alloc();
+        *(volatile size *)p = i;
+        a->release(p);
+    }
+    bench_report(a->name, "pair", (uint64_t)n, bench_now_ns() - start);
+}
+
+static void bench_batch(const Allocator *a, void **objs, size n) {
+    const BatchArgs args = {a, objs, n, 42};
+    run_batch(&args);
+    // alloc and release count as one operation each.
+    bench_report(a->name, "batch", (uint64_t)(2 * n), run_batch(&args));
+}
+
+static void run_threads(const Allocator *a, void **objs, size n,
+                        int threads) {
+    pthread_t *tids = malloc((size_t)threads * sizeof(*tids));
+    BatchArgs *args = malloc((size_t)threads * sizeof(*args));
+    if (tids == nullptr || args == nullptr) {
+        exit(EXIT_FAILURE);
+    }
+    const size per_thread = n / threads;
+    for (int i = 0; i < threads; i++) {
+        args[i] = (BatchArgs){a, objs + (i * per_thread), per_thread,
+                              (u64)i + 1};
+        if (pthread_create(&tids[i], nullptr, batch_thread, &args[i]) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], nullptr);
+    }
+    free(args);
+    free(tids);
+}
+
+static void bench_threads(const Allocator *a, void **objs, size n,
+                          int threads) {
+    run_threads(a, objs, n, threads);
+    const uint64_t start = bench_now_ns();
+    run_threads(a, objs, n, threads);
+    const size per_thread = n / threads;
+    bench_report(a->name, "threads", (uint64_t)(2 * per_thread * threads),
+                 bench_now_ns() - start);
+}
+
+static void bench_reset(void **objs, size n) {
+    uint64_t start = 0;
+    for (int run = 0; run < 2; run++) {
+        start = bench_now_ns();
+        for (size i = 0; i < n; i++) {
+            objs[i] = helloc_pool_alloc(&g_pool);
+        }
+        helloc_pool_reset(&g_pool);
+    }
+    bench_report("pool", "batch+reset", (uint64_t)n, bench_now_ns() - start);
+}
+
+int main(int argc, char **argv) {
+    const size n =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_OBJECTS;
+    const int threads =
+        argc > 2 ? (int)strtol(argv[2], nullptr, 10) : DEFAULT_THREADS;
+    if (n <= 0 || threads <= 0 || threads > n) {
+        fprintf(stderr, "usage: %s [objects > 0] [threads > 0]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    void **objs = malloc((size_t)n * sizeof(*objs));
+    if (objs == nullptr ||
+        helloc_pool_init(&g_pool, OBJECT_SIZE, 16) != E_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    printf("--- %td objects of %d bytes, %d threads ---\n", n, OBJECT_SIZE,
+           threads);
+    for (size i = 0; i < COUNTOF(kAllocators); i++) {
+        bench_pair(&kAllocators[i], n);
+        bench_batch(&kAllocators[i], objs, n);
+        bench_threads(&kAllocators[i], objs, n, threads);
+    }
+    bench_reset(objs, n);
+
+    HellocPoolStats stats;
+    helloc_pool_stats(&g_pool, &stats);
+    printf("pool: %td pages, %td bytes, %td slots, %td in use, %td cached\n",
+           stats.pages, stats.reserved_bytes, stats.capacity, stats.in_use,
+           stats.cached);
+    helloc_pool_free(&g_pool);
+    free(objs);
+    return EXIT_SUCCESS;
+}
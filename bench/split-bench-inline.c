@@ -0,0 +1,39 @@
+/// @file split-bench-inline.c
+/// @brief The loops of split-bench, compiled with helloc.h in single-header
+/// mode (HELLOC_IMPLEMENTATION is defined by the HellocHeaderOnly target).
+///
+/// The loops must stay identical to their out-of-line twins in
+/// split-bench.c.
+
+#include <stdlib.h>
+
+#include "split-bench.h"
+
+#ifndef HELLOC_IMPLEMENTATION
+#error "split-bench-inline.c must be compiled in single-header mode"
+#endif
+
+uint64_t split_bench_s8_inline(const s8 *in, size n) {
+    uint64_t total = 0;
+    for (size i = 0; i < n; i++) {
+        s8 left;
+        s8 right;
+        helloc_s8_split_once(in[i], ':', &left, &right);
+        total += (uint64_t)(left.len + right.len);
+    }
+    return total;
+}
+
+uint64_t split_bench_str_inline(char *const *in, size n) {
+    uint64_t found = 0;
+    for (size i = 0; i < n; i++) {
+        char *left = nullptr;
+        char *right = nullptr;
+        if (helloc_str_split_once(in[i], ':', &left, &right) == E_SUCCESS) {
+            found += right != nullptr;
+        }
+        free(left);
+        free(right);
+    }
+    return found;
+}
@@ -0,0 +1,114 @@
+/// @file split-bench.c
+/// @brief Compares inlined and out-of-line calls of the helloc split
+/// functions with a constant delimiter.
+///
+/// Usage: `split-bench [inputs]` (default: 1000000)
+///
+/// The inputs are short "key:value" strings of 5 to 14 bytes, for which the
+/// call itself is a large part of the work.  Each function is measured twice:
+///
+/// * `inline`: compiled in single-header mode (see HELLOC_IMPLEMENTATION in
+///   helloc.h), so the compiler inlines the function into the loop and
+///   specializes it for the delimiter ':'.  See split-bench-inline.c.
+/// * `call`: a regular call into the Helloc library.
+///
+/// The functions under test are:
+///
+/// * `s8_split_once`: helloc_s8_split_once(), which does not allocate.  The
+///   inputs are split SPLIT_REPEAT times to get stable numbers.
+/// * `str_split_once`: helloc_str_split_once(), which allocates both parts,
+///   so malloc() and free() hide most of the call overhead.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "helloc.h"
+#include "split-bench.h"
+
+enum { DEFAULT_INPUTS = 1000000, SPLIT_REPEAT = 10 };
+
+static uint64_t split_bench_s8_call(const s8 *in, size n) {
+    uint64_t total = 0;
+    for (size i = 0; i < n; i++) {
+        s8 left;
+        s8 right;
+        helloc_s8_split_once(in[i], ':', &left, &right);
+        total += (uint64_t)(left.len + right.len);
+    }
+    return total;
+}
+
+static uint64_t split_bench_str_call(char *const *in, size n) {
+    uint64_t found = 0;
+    for (size i = 0; i < n; i++) {
+        char *left = nullptr;
+        char *right = nullptr;
+        if (helloc_str_split_once(in[i], ':', &left, &right) == E_SUCCESS) {
+            found += right != nullptr;
+        }
+        free(left);
+        free(right);
+    }
+    return found;
+}
+
+static void bench_s8(const char *name, uint64_t (*fn)(const s8 *, size),
+                     const s8 *in, size n) {
+    uint64_t total = 0;
+    const uint64_t start = bench_now_ns();
+    for (int r = 0; r < SPLIT_REPEAT; r++) {
+        total += fn(in, n);
+    }
+    bench_report(name, "s8_split_once", (uint64_t)n * SPLIT_REPEAT,
+                 bench_now_ns() - start);
+    bench_keep(total);
+}
+
+static void bench_str(const char *name, uint64_t (*fn)(char *const *, size),
+                      char *const *in, size n) {
+    const uint64_t start = bench_now_ns();
+    const uint64_t found = fn(in, n);
+    bench_report(name, "str_split_once", (uint64_t)n, bench_now_ns() - start);
+    bench_keep(found);
+}
+
+int main(int argc, char **argv) {
+    const size n =
+        argc > 1 ? (size)strtoll(argv[1], nullptr, 10) : DEFAULT_INPUTS;
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [inputs > 0]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    // "k" and "v" with up to 6 digits each, the delimiter, and the NUL
+    // terminator.
+    const size max_len = 16;
+    char *buf = malloc((size_t)(n * max_len));
+    s8 *in = malloc((size_t)n * sizeof(*in));
+    char **strs = malloc((size_t)n * sizeof(*strs));
+    if (buf == nullptr || in == nullptr || strs == nullptr) {
+        fprintf(stderr, "failed to allocate inputs for n=%td\n", n);
+        return EXIT_FAILURE;
+    }
+    uint64_t rng = 0x12345678;
+    for (size i = 0; i < n; i++) {
+        char *p = buf + (i * max_len);
+        const int len = snprintf(p, (size_t)max_len, "k%d:v%d",
+                                 (int)(bench_rand(&rng) % 1000000),
+                                 (int)(bench_rand(&rng) % 1000000));
+        in[i] = (s8){(u8 *)p, len};
+        strs[i] = p;
+    }
+
+    printf("--- %td inputs ---\n", n);
+    bench_s8("inline", split_bench_s8_inline, in, n);
+    bench_s8("call", split_bench_s8_call, in, n);
+    bench_str("inline", split_bench_str_inline, strs, n);
+    bench_str("call", split_bench_str_call, strs, n);
+
+    free(strs);
+    free(in);
+    free(buf);
+    return EXIT_SUCCESS;
+}
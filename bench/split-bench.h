@@ -0,0 +1,28 @@
+/// @file split-bench.h
+/// @brief The loops of split-bench that use helloc.h in single-header mode.
+///
+/// They are defined in split-bench-inline.c, which links the
+/// HellocHeaderOnly target, while split-bench.c calls the same functions out
+/// of line from the Helloc library.
+
+// Inclusion guard
+#ifndef HELLOC_SPLIT_BENCH_H
+#define HELLOC_SPLIT_BENCH_H
+
+#include <stdint.h>
+
+#include "helloc.h"
+
+/// @brief Splits every input at ':' with helloc_s8_split_once().
+///
+/// @returns The total length of all parts, so the work cannot be optimized
+/// away.
+uint64_t split_bench_s8_inline(const s8 *in, size n);
+
+/// @brief Splits every input at ':' with helloc_str_split_once() and frees
+/// the parts.
+///
+/// @returns The number of inputs that contained the delimiter.
+uint64_t split_bench_str_inline(char *const *in, size n);
+
+#endif // HELLOC_SPLIT_BENCH_H
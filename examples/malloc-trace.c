@@ -0,0 +1,346 @@
+/**
+ * @file malloc-trace.c
+ *
+ * @brief LD_PRELOAD shim that records every malloc(), calloc(), realloc() and
+ * free() call of a process into a compact binary trace.
+ *
+ * Replay the trace against different allocators with `malloc-replay` (see
+ * `bench/malloc-replay.c`).  The trace format is described in
+ * malloc-trace.h.
+ *
+ * ## Usage
+ *
+ * ```
+ * $ HELLOC_MALLOC_TRACE=/tmp/ls.trace \
+ *     LD_PRELOAD=build/examples/Release/libmalloc-trace.so ls -l
+ * $ build/bench/Release/malloc-replay /tmp/ls.trace
+ * ```
+ *
+ * ## Notes
+ *
+ * * Linux only, because it relies on `dlsym(RTLD_NEXT, ...)` to find the
+ *   real allocator functions of the C library.
+ * * Records of all threads go into one buffer that is protected by a spin
+ *   lock, so the trace is a valid sequential order of the calls.  A free()
+ *   is recorded before the memory is released, and a realloc() holds the
+ *   lock during the call, so no other thread can record an allocation at the
+ *   same address before the release.
+ * * Allocations made through other functions, e.g. posix_memalign(), are not
+ *   recorded.  The replay skips frees of pointers it has never seen.
+ * * Child processes write their own traces to `<path>.<pid>`: forked
+ *   children reopen the trace in a pthread_atfork() handler, and the shim
+ *   sets MALLOC_TRACE_NESTED_ENV for executed programs, which inherit
+ *   LD_PRELOAD.  Only the first traced process writes to `<path>`.
+ */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "malloc-trace.h"
+
+// Records are collected in this buffer and written out when it is full.
+enum { TRACE_BUFFER_SIZE = 1 << 16, BOOTSTRAP_SIZE = 1 << 12 };
+
+// Set in the environment of the programs that a traced process executes, so
+// that they do not truncate the trace of their parent.
+#define MALLOC_TRACE_NESTED_ENV "HELLOC_MALLOC_TRACE_NESTED"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+static void *(*g_real_malloc)(size_t);
+static void *(*g_real_calloc)(size_t, size_t);
+static void *(*g_real_realloc)(void *, size_t);
+static void (*g_real_free)(void *);
+
+static atomic_flag g_lock = ATOMIC_FLAG_INIT;
+static int g_fd = -1;
+static uint8_t g_buf[TRACE_BUFFER_SIZE];
+static size_t g_buf_len;
+static uint64_t g_prev_addr;
+// The trace path as configured, without the `.<pid>` suffix of children.
+static char g_path[PATH_MAX];
+
+// dlsym() may call calloc() before we know the real calloc(), so such early
+// requests are served from this buffer.  Its memory is never freed.
+static _Alignas(max_align_t) uint8_t g_bootstrap[BOOTSTRAP_SIZE];
+static size_t g_bootstrap_used;
+static atomic_bool g_initializing;
+
+// Set while the current thread is inside a hook, so that allocations made by
+// the hooks themselves (e.g., by dlsym) are not recorded.  The initial-exec
+// TLS model avoids __tls_get_addr(), which may itself call malloc().
+static _Thread_local int t_in_hook __attribute__((tls_model("initial-exec")));
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+static void *bootstrap_alloc(size_t n) {
+    const size_t align = _Alignof(max_align_t);
+    const size_t start = (g_bootstrap_used + align - 1) & ~(align - 1);
+    if (n > BOOTSTRAP_SIZE - start) {
+        return nullptr;
+    }
+    g_bootstrap_used = start + n;
+    return g_bootstrap + start;
+}
+
+static int is_bootstrap(const void *p) {
+    const uint8_t *b = p;
+    return b >= g_bootstrap && b < g_bootstrap + BOOTSTRAP_SIZE;
+}
+
+// Converts the result of dlsym() to a function pointer without the
+// conversion from an object pointer that ISO C does not allow.
+#define LOAD_SYMBOL(fn, name)                                                  \
+    do {                                                                       \
+        void *sym = dlsym(RTLD_NEXT, name);                                    \
+        memcpy(&(fn), &sym, sizeof(fn));                                       \
+    } while (0)
+
+static void resolve_real_functions(void) {
+    if (g_real_free != nullptr || atomic_exchange(&g_initializing, true)) {
+        return;
+    }
+    LOAD_SYMBOL(g_real_malloc, "malloc");
+    LOAD_SYMBOL(g_real_calloc, "calloc");
+    LOAD_SYMBOL(g_real_realloc, "realloc");
+    LOAD_SYMBOL(g_real_free, "free");
+    atomic_store(&g_initializing, false);
+}
+
+static void lock(void) {
+    while (atomic_flag_test_and_set_explicit(&g_lock, memory_order_acquire)) {
+        // spin
+    }
+}
+
+static void unlock(void) {
+    atomic_flag_clear_explicit(&g_lock, memory_order_release);
+}
+
+// Writes the buffered records to the trace file.  Requires the lock.
+static void flush_locked(void) {
+    size_t off = 0;
+    while (g_fd >= 0 && off < g_buf_len) {
+        const ssize_t n = write(g_fd, g_buf + off, g_buf_len - off);
+        if (n <= 0) {
+            // Stop tracing rather than failing the traced process.
+            close(g_fd);
+            g_fd = -1;
+            break;
+        }
+        off += (size_t)n;
+    }
+    g_buf_len = 0;
+}
+
+static void put_addr_locked(const void *p) {
+    const uint64_t addr = (uint64_t)(uintptr_t)p;
+    g_buf_len += malloc_trace_put_varint(
+        g_buf + g_buf_len, malloc_trace_zigzag((int64_t)(addr - g_prev_addr)));
+    g_prev_addr = addr;
+}
+
+// Appends one record.  Fields that an op does not use are ignored.
+// Requires the lock.
+static void record_locked(MallocTraceOp op, const void *ptr, size_t size,
+                          const void *result) {
+    if (g_fd < 0) {
+        return;
+    }
+    if (g_buf_len > TRACE_BUFFER_SIZE - (1 + (3 * MALLOC_TRACE_MAX_VARINT))) {
+        flush_locked();
+    }
+    g_buf[g_buf_len++] = (uint8_t)op;
+    switch (op) {
+    case MALLOC_TRACE_MALLOC:
+    case MALLOC_TRACE_CALLOC:
+        g_buf_len += malloc_trace_put_varint(g_buf + g_buf_len, size);
+        put_addr_locked(result);
+        break;
+    case MALLOC_TRACE_REALLOC:
+        put_addr_locked(ptr);
+        g_buf_len += malloc_trace_put_varint(g_buf + g_buf_len, size);
+        put_addr_locked(result);
+        break;
+    case MALLOC_TRACE_FREE:
+        put_addr_locked(ptr);
+        break;
+    }
+}
+
+static void record(MallocTraceOp op, const void *ptr, size_t size,
+                   const void *result) {
+    lock();
+    record_locked(op, ptr, size, result);
+    unlock();
+}
+
+// Creates the trace file and writes its header.  Returns the file
+// descriptor, or -1.  A child process appends `.<pid>` to the path.
+static int create_trace(bool child) {
+    char pid_path[PATH_MAX + 32];
+    const char *path = g_path;
+    if (child) {
+        snprintf(pid_path, sizeof(pid_path), "%s.%ld", g_path,
+                 (long)getpid());
+        path = pid_path;
+    }
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    MallocTraceHeader header = {.version = MALLOC_TRACE_VERSION};
+    memcpy(header.magic, MALLOC_TRACE_MAGIC, sizeof(header.magic));
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The fork handlers keep the lock across fork(), so that the child does not
+// inherit it locked by a thread that does not exist there.  The forking
+// thread does not record its own allocations meanwhile.
+static void before_fork(void) {
+    t_in_hook = 1;
+    lock();
+}
+
+static void after_fork_parent(void) {
+    unlock();
+    t_in_hook = 0;
+}
+
+// The child drops the buffered records of the parent, which the parent
+// writes itself, and continues in its own trace file.
+static void after_fork_child(void) {
+    g_buf_len = 0;
+    g_prev_addr = 0;
+    if (g_fd >= 0) {
+        close(g_fd);
+        g_fd = create_trace(true);
+    }
+    unlock();
+    t_in_hook = 0;
+}
+
+__attribute__((constructor)) static void trace_open(void) {
+    t_in_hook = 1;
+    resolve_real_functions();
+    const char *path = getenv(MALLOC_TRACE_ENV);
+    if (path == nullptr || path[0] == '\0') {
+        path = MALLOC_TRACE_DEFAULT_PATH;
+    }
+    if (strlen(path) < sizeof(g_path)) {
+        strcpy(g_path, path);
+        const int fd = create_trace(getenv(MALLOC_TRACE_NESTED_ENV) != nullptr);
+        if (fd >= 0) {
+            setenv(MALLOC_TRACE_NESTED_ENV, "1", 1);
+            pthread_atfork(before_fork, after_fork_parent, after_fork_child);
+            lock();
+            g_fd = fd;
+            unlock();
+        }
+    }
+    t_in_hook = 0;
+}
+
+__attribute__((destructor)) static void trace_close(void) {
+    lock();
+    flush_locked();
+    if (g_fd >= 0) {
+        close(g_fd);
+        g_fd = -1;
+    }
+    unlock();
+}
+
+void *malloc(size_t size) {
+    resolve_real_functions();
+    if (g_real_malloc == nullptr) {
+        return bootstrap_alloc(size);
+    }
+    void *p = g_real_malloc(size);
+    if (!t_in_hook) {
+        t_in_hook = 1;
+        record(MALLOC_TRACE_MALLOC, nullptr, size, p);
+        t_in_hook = 0;
+    }
+    return p;
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    resolve_real_functions();
+    if (g_real_calloc == nullptr) {
+        // Static memory is already zeroed.
+        return nmemb == 0 || size <= SIZE_MAX / nmemb
+                   ? bootstrap_alloc(nmemb * size)
+                   : nullptr;
+    }
+    void *p = g_real_calloc(nmemb, size);
+    if (!t_in_hook) {
+        t_in_hook = 1;
+        record(MALLOC_TRACE_CALLOC, nullptr, nmemb * size, p);
+        t_in_hook = 0;
+    }
+    return p;
+}
+
+void *realloc(void *ptr, size_t size) {
+    resolve_real_functions();
+    if (ptr == nullptr) {
+        return malloc(size);
+    }
+    if (is_bootstrap(ptr)) {
+        // Rare: move a bootstrap allocation to the real heap.  The old size
+        // is unknown, so copy up to the end of the bootstrap buffer.
+        void *p = malloc(size);
+        if (p != nullptr) {
+            const size_t avail =
+                (size_t)(g_bootstrap + BOOTSTRAP_SIZE - (uint8_t *)ptr);
+            memcpy(p, ptr, size < avail ? size : avail);
+        }
+        return p;
+    }
+    if (g_real_realloc == nullptr) {
+        // Only bootstrap allocations exist before the real functions are
+        // known.
+        return nullptr;
+    }
+    if (t_in_hook) {
+        return g_real_realloc(ptr, size);
+    }
+    // realloc() may release ptr, so the record must be written before
+    // another thread can get the same address.  It may also fail and keep
+    // ptr, so the release cannot be recorded in advance.
+    t_in_hook = 1;
+    lock();
+    void *p = g_real_realloc(ptr, size);
+    record_locked(MALLOC_TRACE_REALLOC, ptr, size, p);
+    unlock();
+    t_in_hook = 0;
+    return p;
+}
+
+void free(void *ptr) {
+    if (ptr == nullptr || is_bootstrap(ptr)) {
+        return;
+    }
+    resolve_real_functions();
+    // Record first, so that another thread cannot record an allocation at
+    // the same address before the free.
+    if (!t_in_hook) {
+        t_in_hook = 1;
+        record(MALLOC_TRACE_FREE, ptr, 0, nullptr);
+        t_in_hook = 0;
+    }
+    g_real_free(ptr);
+}
@@ -0,0 +1,90 @@
+/// @file malloc-trace.h
+/// @brief Binary format of the allocation traces written by malloc-trace.c.
+///
+/// A trace file starts with a MallocTraceHeader, followed by one record per
+/// intercepted call.  Each record is an op byte followed by LEB128 varints:
+///
+/// | op                   | fields                      |
+/// |----------------------|-----------------------------|
+/// | MALLOC_TRACE_MALLOC  | size, result                |
+/// | MALLOC_TRACE_CALLOC  | size (nmemb * size), result |
+/// | MALLOC_TRACE_REALLOC | ptr, size, result           |
+/// | MALLOC_TRACE_FREE    | ptr                         |
+///
+/// Addresses (ptr, result) are not stored as-is but as the zigzag-encoded
+/// difference to the previous address in the trace.  Consecutive allocations
+/// tend to be close to each other, so most records take 3 to 6 bytes.
+
+// Inclusion guard
+#ifndef MALLOC_TRACE_H
+#define MALLOC_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_TRACE_MAGIC "HLCTRACE"
+#define MALLOC_TRACE_VERSION 1
+
+/// Name of the environment variable that sets the trace file path.
+#define MALLOC_TRACE_ENV "HELLOC_MALLOC_TRACE"
+/// Trace file path if MALLOC_TRACE_ENV is not set.
+#define MALLOC_TRACE_DEFAULT_PATH "malloc.trace"
+
+typedef struct {
+    char magic[8]; // MALLOC_TRACE_MAGIC, without NUL terminator
+    uint32_t version;
+    uint32_t reserved;
+} MallocTraceHeader;
+
+typedef enum {
+    MALLOC_TRACE_MALLOC = 1,
+    MALLOC_TRACE_CALLOC = 2,
+    MALLOC_TRACE_REALLOC = 3,
+    MALLOC_TRACE_FREE = 4
+} MallocTraceOp;
+
+/// Maximum number of bytes of an encoded 64-bit varint.
+#define MALLOC_TRACE_MAX_VARINT 10
+
+/// @brief Encodes v as LEB128 varint into out.
+///
+/// @returns The number of bytes written, at most MALLOC_TRACE_MAX_VARINT.
+static inline size_t malloc_trace_put_varint(uint8_t *out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+/// @brief Decodes a LEB128 varint from [*p, end) and advances *p.
+///
+/// @returns 0 if successful, -1 if the input is truncated or malformed.
+static inline int malloc_trace_get_varint(const uint8_t **p,
+                                          const uint8_t *end, uint64_t *v) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*p == end) {
+            return -1;
+        }
+        const uint8_t b = *(*p)++;
+        result |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *v = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static inline uint64_t malloc_trace_zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t malloc_trace_unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+#endif // MALLOC_TRACE_H
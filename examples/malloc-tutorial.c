@@ -7,6 +7,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "malloc-tutorial.h"
+
 /**
  * @file malloc-tutorial.c
  *
@@ -31,6 +33,9 @@
  * ```
  *
  * Common values are 4096 on x86_64 and 16,384 on arm64, such as macOS.
+ *
+ * Define `MALLOC_TUTORIAL_NO_MAIN` to compile this file without its main(),
+ * e.g. to link my_malloc() and my_free() into `bench/malloc-replay.c`.
  */
 
 /**
@@ -158,6 +163,7 @@ void my_free(void *ptr) {
     block_ptr->magic = MAGIC_BLOCK_FREED;
 }
 
+#ifndef MALLOC_TUTORIAL_NO_MAIN
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
 int main(void) {
     printf("===============================================================\n");
@@ -246,3 +252,4 @@ int main(void) {
     return EXIT_SUCCESS;
 }
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+#endif // MALLOC_TUTORIAL_NO_MAIN
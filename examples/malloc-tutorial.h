@@ -0,0 +1,24 @@
+/// @file malloc-tutorial.h
+/// @brief The allocator functions of malloc-tutorial.c.
+///
+/// WARNING: For educational purposes only.  The allocator is not thread-safe,
+/// never returns memory to the OS, and searches all blocks on every
+/// my_malloc() call.
+
+// Inclusion guard
+#ifndef MALLOC_TUTORIAL_H
+#define MALLOC_TUTORIAL_H
+
+#include <stddef.h>
+
+/// @brief Allocates size bytes, aligned to the word size.
+///
+/// @returns A pointer to the memory, or NULL if sbrk() failed.
+void *my_malloc(size_t size);
+
+/// @brief Marks the memory at ptr as free so that my_malloc() can reuse it.
+///
+/// @param[in] ptr A pointer returned by my_malloc(), or NULL.
+void my_free(void *ptr);
+
+#endif // MALLOC_TUTORIAL_H
@@ -1,5 +1,19 @@
 /// @file helloc.h
 /// @brief Provides string-related functions plus some toy functions.
+///
+/// The library can be used in two ways:
+///
+/// * Link the `Helloc` library and include this header as usual.
+/// * Single-header mode, like stb_ds and zpl: define `HELLOC_IMPLEMENTATION`
+///   before including this header (or link the `HellocHeaderOnly` CMake
+///   target, which defines it).  All functions are then defined as
+///   `static inline` in every translation unit, so the compiler can inline
+///   them and specialize them for constant arguments, such as the delimiter
+///   of helloc_s8_split_once().  All other helloc headers (helloc_arena.h,
+///   helloc_map.h, helloc_pool.h, ...) still require the `Helloc` library.
+///
+/// In single-header mode, define `HELLOC_IMPLEMENTATION` before including any
+/// helloc header, because a translation unit cannot mix both modes.
 
 // Inclusion guard
 #ifndef HELLOC_H
@@ -7,6 +21,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -49,14 +64,14 @@ typedef struct {
 
 // Wrap a C string literal as s8.
 #define s8(s)                                                                  \
-    (s8) { (u8 *)(s), lengthof(s) }
+    (s8) { (u8 *)(s), LENGTHOF(s) }
 // NOLINTEND(readability-identifier-naming)
 
 #define SIZEOF(x) ((size)(sizeof(x)))
 #define ALIGNOF(x) ((size)(_Alignof(x)))
 #define COUNTOF(...) ((size)(sizeof(__VA_ARGS__) / sizeof(*__VA_ARGS__)))
-#define LENGTHOF(s) ((countof(s)) - 1)
-#define NEW(a, t, n) ((t *)(alloc(a, (sizeof(t)), (alignof(t)), (n))))
+#define LENGTHOF(s) ((COUNTOF(s)) - 1)
+#define NEW(a, t, n) ((t *)(alloc(a, SIZEOF(t), ALIGNOF(t), (n))))
 
 // To enable assertions in release builds, put UBSan in trap mode with
 // ``-fsanitize-trap` and then enable at least `-fsanitize=unreachable`.
@@ -72,15 +87,34 @@ typedef enum {
     /// When the caller provided invalid input argument(s).
     E_INVALID_INPUT = 1,
     /// When memory allocation failed within a function.
-    E_MEMORY_ALLOCATION_FAILED = 2
+    E_MEMORY_ALLOCATION_FAILED = 2,
+    /// When an I/O operation failed.  errno describes the error.
+    E_IO_FAILED = 3
 } Result;
 
+#if defined(HELLOC_IMPLEMENTATION) && defined(HELLOC_BUILD_LIBRARY)
+#error "HELLOC_IMPLEMENTATION must not be defined when building the library"
+#endif
+
+// The linkage of the library functions: `static inline` in single-header
+// mode, external otherwise.
+#ifdef HELLOC_IMPLEMENTATION
+#define HELLOC_DEF static inline
+#else
+#define HELLOC_DEF
+#endif
+
+/// The version of this header.  The CMake build checks that it matches the
+/// project version, so that single-header mode does not depend on the
+/// `PROJECT_VERSION` definition of this repository's build.
+#define HELLOC_VERSION "0.1.0.0"
+
 /// @brief Returns the version of the linked helloc library.
 ///
 /// Example return value: "0.1.0-0"
 ///
 /// @returns The library version.
-const char *helloc_library_version(void);
+HELLOC_DEF const char *helloc_library_version(void);
 
 /// @brief Create an owned copy of the string.
 ///
@@ -98,7 +132,7 @@ const char *helloc_library_version(void);
 /// @returns An owned copy of the string.  That is, the ownership (e.g., to
 /// `free()`) is passed to the caller.
 /// @returns NULL if memory allocation failed.
-char *helloc_str_dup(const char *s);
+HELLOC_DEF char *helloc_str_dup(const char *s);
 
 /// @brief Split the string at the first occurrence of the delimiter.
 ///
@@ -130,8 +164,34 @@ char *helloc_str_dup(const char *s);
 /// @returns E_SUCCESS if successful.
 /// @returns E_INVALID_INPUT if s is NULL.
 /// @returns E_MEMORY_ALLOCATION_FAILED
-Result helloc_str_split_once(const char *s, char delim, char **lout,
-                             char **rout);
+HELLOC_DEF Result helloc_str_split_once(const char *s, char delim,
+                                        char **lout, char **rout);
+
+/// @brief Split the string at the first occurrence of the delimiter, without
+/// copying.
+///
+/// Unlike helloc_str_split_once(), the parts point into s, so nothing is
+/// allocated and nothing needs to be freed.
+///
+/// Example:
+///
+/// ```
+/// s8 key;
+/// s8 value;
+/// if (helloc_s8_split_once(s8("foo:bar"), ':', &key, &value)) {
+///     // key is "foo", value is "bar"
+/// }
+/// ```
+///
+/// @param[in] s The input string to be split.
+/// @param[in] delim The delimiter by which to split.
+/// @param[out] left Stores the part before the delimiter, or all of s when
+/// the delimiter was not found.  Must not be NULL.
+/// @param[out] right Stores the part after the delimiter, or an empty string
+/// with NULL data when the delimiter was not found.  Must not be NULL.
+///
+/// @returns true if the delimiter was found, false otherwise.
+HELLOC_DEF bool helloc_s8_split_once(s8 s, u8 delim, s8 *left, s8 *right);
 
 /// @brief Trims leading and trailing whitespace from a string.
 ///
@@ -158,7 +218,7 @@ Result helloc_str_split_once(const char *s, char delim, char **lout,
 /// ```
 /// @returns The length of the trimmed string stored in the output buffer,
 ///          with the invariant 0 <= trimmed length <= out_len.
-size_t helloc_str_trim(const char *s, char *out, size_t out_len);
+HELLOC_DEF size_t helloc_str_trim(const char *s, char *out, size_t out_len);
 
 /// @brief Computes the sum of two ints.
 ///
@@ -169,7 +229,7 @@ size_t helloc_str_trim(const char *s, char *out, size_t out_len);
 /// @param b The second int
 ///
 /// @returns The sum of the inputs.
-int helloc_sum(int a, int b);
+HELLOC_DEF int helloc_sum(int a, int b);
 
 // Short names for the library API
 #ifdef HELLOC_SHORT_NAMES
@@ -178,7 +238,146 @@ int helloc_sum(int a, int b);
 #define str_dup helloc_str_dup
 #define str_split_once helloc_str_split_once
 #define str_trim helloc_str_trim
+#define s8_split_once helloc_s8_split_once
 // NOLINTEND(readability-identifier-naming)
 #endif // HELLOC_SHORT_NAMES
 
+//---------------------------------------------------------------------------//
+// Implementation, compiled into the `Helloc` library by helloc.c, or into
+// every translation unit that defines HELLOC_IMPLEMENTATION.
+//---------------------------------------------------------------------------//
+#if defined(HELLOC_IMPLEMENTATION) || defined(HELLOC_BUILD_LIBRARY)
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+HELLOC_DEF const char *helloc_library_version(void) { return HELLOC_VERSION; }
+
+HELLOC_DEF char *helloc_str_dup(const char *s) {
+    size_t n = strlen(s) + 1;
+    char *p = malloc(n);
+    if (p != nullptr) {
+        memcpy(p, s, n);
+    }
+    return p;
+}
+
+HELLOC_DEF Result helloc_str_split_once(const char *s, const char delim,
+                                        char **lout, char **rout) {
+    if (s == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    const char *colon_pos = strchr(s, delim);
+    if (colon_pos != nullptr) {
+        // Calculate the length of the left part.
+        size_t lout_len = (size_t)(colon_pos - s);
+
+        // Allocate memory for the left part and copy the characters.
+        *lout = malloc(lout_len + 1);
+        if (*lout == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        strncpy(*lout, s, lout_len);
+        (*lout)[lout_len] = 0; // Null-terminate the left part.
+
+        // Allocate memory for the right part and copy the characters.
+        *rout = helloc_str_dup(colon_pos + 1);
+        if (*rout == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+    } else {
+        // No delimiter found.
+        *lout = helloc_str_dup(s);
+        *rout = nullptr;
+    }
+    return E_SUCCESS;
+}
+
+// Returns the index of the first occurrence of c in s, or s.len if there is
+// none.  Searches 8 bytes at a time (SWAR) rather than calling memchr(), so
+// that the search is inlined in single-header mode, and a constant c folds
+// into the constant `pattern`.
+static inline size helloc_s8_find_byte_(s8 s, u8 c) {
+    const u64 ones = 0x0101010101010101;
+    const u64 highs = 0x8080808080808080;
+    const u64 pattern = ones * c;
+    size i = 0;
+    for (; i + 8 <= s.len; i += 8) {
+        u64 word;
+        memcpy(&word, s.data + i, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        // The first byte in memory must be the least significant one.
+        word = __builtin_bswap64(word);
+#endif
+        word ^= pattern; // bytes equal to c become 0
+        // The borrow may mark more significant bytes after a zero byte as
+        // false positives, but the least significant zero byte, which is the
+        // first one in memory, is always marked correctly.
+        const u64 zeros = (word - ones) & ~word & highs;
+        if (zeros != 0) {
+            return i + (__builtin_ctzll(zeros) / 8);
+        }
+    }
+    for (; i < s.len; i++) {
+        if (s.data[i] == c) {
+            return i;
+        }
+    }
+    return s.len;
+}
+
+HELLOC_DEF bool helloc_s8_split_once(s8 s, u8 delim, s8 *left, s8 *right) {
+    const size i = helloc_s8_find_byte_(s, delim);
+    if (i == s.len) {
+        *left = s;
+        *right = (s8){nullptr, 0};
+        return false;
+    }
+    *left = (s8){s.data, i};
+    *right = (s8){s.data + i + 1, s.len - i - 1};
+    return true;
+}
+
+HELLOC_DEF size_t helloc_str_trim(const char *s, char *out, size_t out_len) {
+    if (out == nullptr || out_len == 0) {
+        return 0;
+    }
+
+    // Trim leading space
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+
+    // Trim trailing space
+    const char *end = s + strlen(s) - 1;
+    while (end > s && isspace((unsigned char)*end)) {
+        end--;
+    }
+    end++;
+
+    const size_t len = (size_t)(end - s);
+    size_t trimmed_size = len < out_len - 1 ? len : out_len - 1;
+    memcpy(out, s, trimmed_size);
+    out[trimmed_size] = 0;
+    return trimmed_size;
+}
+
+HELLOC_DEF int helloc_sum(int a, int b) {
+    if (a >= 0) {
+        if (b > INT_MAX - a) {
+            // Integer overflow
+            return INT_MAX;
+        }
+        return a + b;
+    }
+    if (b < INT_MIN - a) {
+        // Integer underflow
+        return INT_MIN;
+    }
+    return a + b;
+}
+
+#endif // HELLOC_IMPLEMENTATION || HELLOC_BUILD_LIBRARY
+
 #endif // HELLOC_H
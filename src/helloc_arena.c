@@ -0,0 +1,44 @@
+/// @file helloc_arena.c
+/// @brief Implementation of the arena allocator.
+
+#include "helloc_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "helloc.h"
+
+Result helloc_arena_init(HellocArena *a, size cap) {
+    if (a == nullptr || cap <= 0) {
+        return E_INVALID_INPUT;
+    }
+    a->mem = malloc((size_t)cap);
+    if (a->mem == nullptr) {
+        *a = (HellocArena){0};
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    a->beg = a->mem;
+    a->end = a->mem + cap;
+    return E_SUCCESS;
+}
+
+void helloc_arena_free(HellocArena *a) {
+    if (a == nullptr) {
+        return;
+    }
+    free(a->mem);
+    *a = (HellocArena){0};
+}
+
+void *helloc_arena_alloc(HellocArena *a, size objsize, size align,
+                         size count) {
+    const size padding = (size)(-(uptr)a->beg & (uptr)(align - 1));
+    const size available = a->end - a->beg - padding;
+    if (objsize <= 0 || count < 0 || available < 0 ||
+        count > available / objsize) {
+        return nullptr;
+    }
+    u8 *p = a->beg + padding;
+    a->beg = p + (objsize * count);
+    return memset(p, 0, (size_t)(objsize * count));
+}
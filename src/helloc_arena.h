@@ -0,0 +1,67 @@
+/// @file helloc_arena.h
+/// @brief Provides a bump (linear) allocator for memory with a shared
+/// lifetime.
+///
+/// An arena owns one block of memory and hands out consecutive pieces of it.
+/// There is no per-allocation free: all allocations are released together by
+/// helloc_arena_free().  See https://nullprogram.com/blog/2023/09/27/.
+
+// Inclusion guard
+#ifndef HELLOC_ARENA_H
+#define HELLOC_ARENA_H
+
+#include "helloc.h"
+
+/// @brief A bump allocator over one fixed block of memory.
+///
+/// Allocations are carved from `beg` upwards, so the most recent allocation
+/// always ends at `beg` and can be extended in place.
+typedef struct {
+    /// Start of the free memory.
+    u8 *beg;
+    /// End of the free memory.
+    u8 *end;
+    /// The block returned by malloc(), for helloc_arena_free().
+    u8 *mem;
+} HellocArena;
+
+/// @brief Initializes an arena with a block of cap bytes from the heap.
+///
+/// @param[out] a The arena to initialize.  Must not be NULL.
+/// @param[in] cap The capacity of the arena in bytes.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if a is NULL or cap is not positive.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_arena_init(HellocArena *a, size cap);
+
+/// @brief Releases the memory of the arena and all allocations from it.
+///
+/// @param[in,out] a The arena to free.  NULL is a no-op.
+void helloc_arena_free(HellocArena *a);
+
+/// @brief Allocates count zeroed objects of objsize bytes each.
+///
+/// Use it through the NEW() macro of helloc.h, e.g.
+/// `NEW(&arena, s8, 16)` with HELLOC_SHORT_NAMES.
+///
+/// @param[in,out] a The arena.  Must not be NULL.
+/// @param[in] objsize The size of one object in bytes.
+/// @param[in] align The alignment of the objects, a power of two.
+/// @param[in] count The number of objects.
+///
+/// @returns A pointer to the zeroed memory.
+/// @returns NULL if the arena does not have enough free memory left.
+void *helloc_arena_alloc(HellocArena *a, size objsize, size align,
+                         size count);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define arena_init helloc_arena_init
+#define arena_free helloc_arena_free
+#define alloc helloc_arena_alloc
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_ARENA_H
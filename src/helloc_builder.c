@@ -0,0 +1,331 @@
+/// @file helloc_builder.c
+/// @brief Implementation of the string builder.
+
+#include "helloc_builder.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "helloc.h"
+#include "helloc_arena.h"
+
+enum {
+    // Initial capacities of the buffer (in bytes) and of the segment array.
+    BUF_MIN_CAP = 64,
+    SEGS_MIN_CAP = 8,
+    // Number of iovecs per writev() call, well below IOV_MAX on Linux (1024)
+    // and macOS (1024).
+    IOV_BATCH = 64
+};
+
+// Grows the array *p, of which `used` of *cap elements are in use, to at
+// least `need` elements by doubling its capacity.  In an arena, the array is
+// extended in place if it is the most recent allocation.
+static Result grow(HellocArena *arena, void **p, size *cap, size used,
+                   size need, size elem, size align, size min_cap) {
+    size new_cap = *cap > min_cap ? *cap : min_cap;
+    while (new_cap < need) {
+        if (new_cap > PTRDIFF_MAX / 2 / elem) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        new_cap *= 2;
+    }
+    if (arena == nullptr) {
+        void *q = realloc(*p, (size_t)(new_cap * elem));
+        if (q == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        *p = q;
+    } else if (*p != nullptr && (u8 *)*p + (*cap * elem) == arena->beg) {
+        const size extra = (new_cap - *cap) * elem;
+        if (arena->end - arena->beg < extra) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        arena->beg += extra;
+    } else {
+        void *q = helloc_arena_alloc(arena, elem, align, new_cap);
+        if (q == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        if (used > 0) {
+            memcpy(q, *p, (size_t)(used * elem));
+        }
+        *p = q;
+    }
+    *cap = new_cap;
+    return E_SUCCESS;
+}
+
+// Makes room for n more bytes in the buffer.
+static Result reserve(HellocBuilder *b, size n) {
+    if (n > PTRDIFF_MAX - b->buf_len) {
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    if (b->buf_len + n <= b->buf_cap) {
+        return E_SUCCESS;
+    }
+    void *p = b->buf;
+    const Result res = grow(b->arena, &p, &b->buf_cap, b->buf_len,
+                            b->buf_len + n, 1, 1, BUF_MIN_CAP);
+    b->buf = p;
+    return res;
+}
+
+static Result push_segment(HellocBuilder *b, const u8 *ref, size off,
+                           size len) {
+    if (b->segs_len == b->segs_cap) {
+        void *p = b->segs;
+        const Result res =
+            grow(b->arena, &p, &b->segs_cap, b->segs_len, b->segs_len + 1,
+                 SIZEOF(HellocBuilderSegment),
+                 ALIGNOF(HellocBuilderSegment), SEGS_MIN_CAP);
+        b->segs = p;
+        if (res != E_SUCCESS) {
+            return res;
+        }
+    }
+    b->segs[b->segs_len++] = (HellocBuilderSegment){ref, off, len};
+    return E_SUCCESS;
+}
+
+// Records that n bytes were copied to the end of the buffer.  Only needed
+// once the content is tracked as segments.
+static Result commit_copy(HellocBuilder *b, size n) {
+    if (b->segs_len > 0) {
+        HellocBuilderSegment *last = &b->segs[b->segs_len - 1];
+        if (last->ref == nullptr && last->off + last->len == b->buf_len) {
+            last->len += n;
+        } else {
+            const Result res = push_segment(b, nullptr, b->buf_len, n);
+            if (res != E_SUCCESS) {
+                return res;
+            }
+        }
+    }
+    b->buf_len += n;
+    b->len += n;
+    return E_SUCCESS;
+}
+
+// Returns the bytes of the i-th segment of the content.
+static s8 segment_at(const HellocBuilder *b, size i) {
+    if (b->segs_len == 0) {
+        return (s8){b->buf, b->buf_len};
+    }
+    const HellocBuilderSegment *seg = &b->segs[i];
+    const u8 *p = seg->ref != nullptr ? seg->ref : b->buf + seg->off;
+    return (s8){(u8 *)(uptr)p, seg->len};
+}
+
+// Removes the content before byte seg_off of segment seg, which has been
+// written.  The copied bytes stay in the buffer until the next reset.
+static void drop_written(HellocBuilder *b, size seg, size seg_off) {
+    if (b->segs_len == 0) {
+        memmove(b->buf, b->buf + seg_off, (size_t)(b->buf_len - seg_off));
+        b->buf_len -= seg_off;
+        b->len -= seg_off;
+        return;
+    }
+    for (size i = 0; i < seg; i++) {
+        b->len -= b->segs[i].len;
+    }
+    memmove(b->segs, b->segs + seg,
+            (size_t)(b->segs_len - seg) * sizeof(*b->segs));
+    b->segs_len -= seg;
+    HellocBuilderSegment *first = &b->segs[0];
+    if (first->ref != nullptr) {
+        first->ref += seg_off;
+    } else {
+        first->off += seg_off;
+    }
+    first->len -= seg_off;
+    b->len -= seg_off;
+}
+
+void helloc_builder_init(HellocBuilder *b, HellocArena *arena) {
+    *b = (HellocBuilder){.arena = arena};
+}
+
+void helloc_builder_free(HellocBuilder *b) {
+    if (b == nullptr) {
+        return;
+    }
+    if (b->arena == nullptr) {
+        free(b->buf);
+        free(b->segs);
+    }
+    *b = (HellocBuilder){.arena = b->arena};
+}
+
+void helloc_builder_reset(HellocBuilder *b) {
+    b->buf_len = 0;
+    b->segs_len = 0;
+    b->len = 0;
+}
+
+size helloc_builder_len(const HellocBuilder *b) { return b->len; }
+
+Result helloc_builder_append(HellocBuilder *b, s8 s) {
+    if (b == nullptr || s.len < 0 || (s.data == nullptr && s.len > 0)) {
+        return E_INVALID_INPUT;
+    }
+    if (s.len == 0) {
+        return E_SUCCESS;
+    }
+    const Result res = reserve(b, s.len);
+    if (res != E_SUCCESS) {
+        return res;
+    }
+    memcpy(b->buf + b->buf_len, s.data, (size_t)s.len);
+    return commit_copy(b, s.len);
+}
+
+Result helloc_builder_append_ref(HellocBuilder *b, s8 s) {
+    if (b == nullptr || s.len < 0 || (s.data == nullptr && s.len > 0)) {
+        return E_INVALID_INPUT;
+    }
+    if (s.len == 0) {
+        return E_SUCCESS;
+    }
+    if (s.len > PTRDIFF_MAX - b->len) {
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    // Switch to tracking the content as segments.
+    if (b->segs_len == 0 && b->buf_len > 0) {
+        const Result res = push_segment(b, nullptr, 0, b->buf_len);
+        if (res != E_SUCCESS) {
+            return res;
+        }
+    }
+    const Result res = push_segment(b, s.data, 0, s.len);
+    if (res != E_SUCCESS) {
+        return res;
+    }
+    b->len += s.len;
+    return E_SUCCESS;
+}
+
+Result helloc_builder_append_i64(HellocBuilder *b, i64 v) {
+    if (b == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    u8 digits[20]; // INT64_MIN has 19 digits plus the sign
+    u8 *end = digits + sizeof(digits);
+    u8 *p = end;
+    u64 u = v < 0 ? -(u64)v : (u64)v;
+    do {
+        *--p = (u8)('0' + (u % 10));
+        u /= 10;
+    } while (u > 0);
+    if (v < 0) {
+        *--p = '-';
+    }
+    return helloc_builder_append(b, (s8){p, end - p});
+}
+
+Result helloc_builder_appendf(HellocBuilder *b, const char *fmt, ...) {
+    if (b == nullptr || fmt == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    size avail = b->buf_cap - b->buf_len;
+    int n = vsnprintf(b->buf != nullptr ? (char *)b->buf + b->buf_len
+                                        : nullptr,
+                      (size_t)avail, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        return E_INVALID_INPUT;
+    }
+    if (n >= avail) {
+        // Too long for the remaining capacity, so format it again after
+        // growing.  vsnprintf() also writes the NUL terminator.
+        const Result res = reserve(b, (size)n + 1);
+        if (res != E_SUCCESS) {
+            return res;
+        }
+        va_start(ap, fmt);
+        n = vsnprintf((char *)b->buf + b->buf_len, (size_t)n + 1, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            return E_INVALID_INPUT;
+        }
+    }
+    return commit_copy(b, n);
+}
+
+Result helloc_builder_s8(HellocBuilder *b, s8 *out) {
+    if (b == nullptr || out == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    if (b->segs_len > 0) {
+        u8 *buf = b->arena == nullptr
+                      ? malloc((size_t)b->len)
+                      : helloc_arena_alloc(b->arena, 1, 1, b->len);
+        if (buf == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        size off = 0;
+        for (size i = 0; i < b->segs_len; i++) {
+            const s8 seg = segment_at(b, i);
+            memcpy(buf + off, seg.data, (size_t)seg.len);
+            off += seg.len;
+        }
+        if (b->arena == nullptr) {
+            free(b->buf);
+        }
+        b->buf = buf;
+        b->buf_len = b->len;
+        b->buf_cap = b->len;
+        b->segs_len = 0;
+    }
+    *out = (s8){b->buf, b->buf_len};
+    return E_SUCCESS;
+}
+
+Result helloc_builder_flush(HellocBuilder *b, int fd) {
+    if (b == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    if (b->len == 0) {
+        return E_SUCCESS;
+    }
+    const size count = b->segs_len > 0 ? b->segs_len : 1;
+    size seg = 0;
+    size seg_off = 0; // bytes of segment `seg` that were already written
+    while (seg < count) {
+        struct iovec iov[IOV_BATCH];
+        int n = 0;
+        for (size i = seg; i < count && n < IOV_BATCH; i++) {
+            const s8 s = segment_at(b, i);
+            const size skip = i == seg ? seg_off : 0;
+            iov[n++] = (struct iovec){s.data + skip, (size_t)(s.len - skip)};
+        }
+        const ssize_t written = writev(fd, iov, n);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            if (written == 0) {
+                errno = EIO; // no progress, but writev() did not set errno
+            }
+            drop_written(b, seg, seg_off);
+            return E_IO_FAILED;
+        }
+        size left = written;
+        while (seg < count && left >= segment_at(b, seg).len - seg_off) {
+            left -= segment_at(b, seg).len - seg_off;
+            seg++;
+            seg_off = 0;
+        }
+        seg_off += left;
+    }
+    helloc_builder_reset(b);
+    return E_SUCCESS;
+}
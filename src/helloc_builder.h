@@ -0,0 +1,179 @@
+/// @file helloc_builder.h
+/// @brief Provides a growable string builder.
+///
+/// Appending n pieces to a builder takes O(total length) time, because the
+/// buffer grows geometrically and the builder tracks its length, unlike
+/// repeated strcat() calls that rescan the string built so far.
+///
+/// The buffer is allocated from the heap, or from an arena (see
+/// helloc_arena.h).  In an arena, the buffer grows in place as long as it is
+/// the most recent allocation of the arena.
+///
+/// Large pieces can be appended by reference with helloc_builder_append_ref()
+/// instead of being copied.  helloc_builder_flush() then writes the copied
+/// and the referenced pieces with a single writev() call.
+
+// Inclusion guard
+#ifndef HELLOC_BUILDER_H
+#define HELLOC_BUILDER_H
+
+#include "helloc.h"
+#include "helloc_arena.h"
+
+/// @brief A run of bytes of a HellocBuilder, either copied or referenced.
+typedef struct {
+    /// The referenced bytes, or NULL if the run is stored in the buffer.
+    const u8 *ref;
+    /// The offset of the run in the buffer, if ref is NULL.
+    size off;
+    size len;
+} HellocBuilderSegment;
+
+/// @brief A growable string builder.
+///
+/// A zero-initialized HellocBuilder is a valid, empty builder that uses the
+/// heap.
+typedef struct {
+    /// The copied bytes.
+    u8 *buf;
+    size buf_len;
+    size buf_cap;
+    /// The content in order.  Only used once a piece has been appended by
+    /// reference; until then, the content is buf[0, buf_len).
+    HellocBuilderSegment *segs;
+    size segs_len;
+    size segs_cap;
+    /// The total length of the content.
+    size len;
+    /// The arena to allocate from, or NULL to use the heap.
+    HellocArena *arena;
+} HellocBuilder;
+
+/// @brief Initializes an empty builder.
+///
+/// @param[out] b The builder to initialize.  Must not be NULL.
+/// @param[in] arena The arena to allocate from, which must outlive the
+/// builder, or NULL to allocate from the heap.
+void helloc_builder_init(HellocBuilder *b, HellocArena *arena);
+
+/// @brief Releases the memory of the builder and resets it to an empty
+/// builder.
+///
+/// Memory from an arena is only released with the arena.
+///
+/// @param[in,out] b The builder to free.  NULL is a no-op.
+void helloc_builder_free(HellocBuilder *b);
+
+/// @brief Removes the content of the builder but keeps its memory.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+void helloc_builder_reset(HellocBuilder *b);
+
+/// @brief Returns the total length of the content in bytes.
+size helloc_builder_len(const HellocBuilder *b);
+
+/// @brief Appends a copy of the string.
+///
+/// Example:
+///
+/// ```
+/// HellocBuilder b;
+/// helloc_builder_init(&b, NULL);
+/// helloc_builder_append(&b, s8("answer="));
+/// helloc_builder_append_i64(&b, 42);
+/// helloc_builder_appendf(&b, " (%.1f%%)\n", 99.5);
+/// helloc_builder_flush(&b, STDOUT_FILENO);
+/// helloc_builder_free(&b);
+/// ```
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[in] s The string to append.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b is NULL or s is invalid.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_builder_append(HellocBuilder *b, s8 s);
+
+/// @brief Appends the string by reference, without copying it.
+///
+/// Use it for large pieces, which helloc_builder_flush() then writes straight
+/// from their own memory.  The caller must keep s.data valid and unchanged
+/// until the builder is flushed, reset or freed.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[in] s The string to append.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b is NULL or s is invalid.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_builder_append_ref(HellocBuilder *b, s8 s);
+
+/// @brief Appends the decimal representation of the integer.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[in] v The integer to append.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b is NULL.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_builder_append_i64(HellocBuilder *b, i64 v);
+
+/// @brief Appends a string formatted like printf().
+///
+/// The string is formatted directly into the buffer of the builder.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[in] fmt The printf() format string.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b or fmt is NULL, or if the formatting failed.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_builder_appendf(HellocBuilder *b, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/// @brief Returns the content of the builder as one contiguous string.
+///
+/// If pieces were appended by reference, they are copied into the buffer
+/// first, so that the references are no longer needed.  The result points
+/// into the builder and is valid until the builder is modified.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[out] out Stores the content.  Must not be NULL.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b or out is NULL.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_builder_s8(HellocBuilder *b, s8 *out);
+
+/// @brief Writes the content to the file descriptor and resets the builder.
+///
+/// Copied and referenced pieces are written together with writev(), which
+/// is retried until everything is written.
+///
+/// @param[in,out] b The builder.  Must not be NULL.
+/// @param[in] fd The file descriptor to write to.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if b is NULL.
+/// @returns E_IO_FAILED if writev() failed; errno describes the error.  The
+/// builder then keeps the content that has not been written, so that the
+/// flush can be retried, e.g. after EAGAIN.
+Result helloc_builder_flush(HellocBuilder *b, int fd);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define builder_init helloc_builder_init
+#define builder_free helloc_builder_free
+#define builder_reset helloc_builder_reset
+#define builder_len helloc_builder_len
+#define builder_append helloc_builder_append
+#define builder_append_ref helloc_builder_append_ref
+#define builder_append_i64 helloc_builder_append_i64
+#define builder_appendf helloc_builder_appendf
+#define builder_s8 helloc_builder_s8
+#define builder_flush helloc_builder_flush
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_BUILDER_H
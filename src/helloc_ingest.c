@@ -0,0 +1,576 @@
+/// @file helloc_ingest.c
+/// @brief Implementation of the batched file ingestion.
+///
+/// The io_uring backend talks to the kernel with raw syscalls, so it does
+/// not need liburing.  See https://kernel.dk/io_uring.pdf for the ring
+/// layout and the memory ordering rules.
+
+// For syscall(), O_CLOEXEC and pread() with `-std=c2x`.
+#define _GNU_SOURCE
+
+#include "helloc_ingest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "helloc.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HELLOC_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+enum {
+    // Limits the threads of the pread() fallback, which block in pread()
+    // rather than compute, independent of a large queue depth.
+    PREAD_THREADS_PER_CPU = 4
+};
+
+// State shared by all workers of one helloc_ingest_files() call.
+typedef struct {
+    const char *const *paths;
+    size n;
+    int queue_depth;
+    size buffer_size;
+    HellocIngestFn fn;
+    void *ctx;
+    HellocIngestStats stats;
+    // Used by the pread() fallback only.
+    atomic_llong next_file;
+    pthread_mutex_t lock;
+} Ingest;
+
+static void deliver(Ingest *in, size file, i64 offset, s8 data, bool eof,
+                    int error) {
+    const HellocIngestChunk chunk = {file, offset, data, eof, error};
+    in->stats.bytes += data.len;
+    in->stats.files_failed += error != 0;
+    in->fn(in->ctx, &chunk);
+}
+
+//---------------------------------------------------------------------------//
+// pread() fallback
+//---------------------------------------------------------------------------//
+
+// Serializes the callbacks of the worker threads.
+static void deliver_locked(Ingest *in, size file, i64 offset, s8 data,
+                           bool eof, int error) {
+    pthread_mutex_lock(&in->lock);
+    deliver(in, file, offset, data, eof, error);
+    pthread_mutex_unlock(&in->lock);
+}
+
+static void pread_file(Ingest *in, size file, u8 *buf) {
+    const int fd = open(in->paths[file], O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        deliver_locked(in, file, 0, (s8){0}, true, errno);
+        return;
+    }
+    i64 offset = 0;
+    for (;;) {
+        const ssize_t r = pread(fd, buf, (size_t)in->buffer_size, offset);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            deliver_locked(in, file, offset, (s8){0}, true, errno);
+            break;
+        }
+        const bool eof = r < in->buffer_size;
+        deliver_locked(in, file, offset, (s8){buf, r}, eof, 0);
+        offset += r;
+        if (eof) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+static void *pread_worker(void *arg) {
+    Ingest *in = arg;
+    u8 *buf = malloc((size_t)in->buffer_size);
+    if (buf == nullptr) {
+        // The other workers, or at least the calling thread, take over.
+        return nullptr;
+    }
+    for (;;) {
+        const size file = (size)atomic_fetch_add(&in->next_file, 1);
+        if (file >= in->n) {
+            break;
+        }
+        pread_file(in, file, buf);
+    }
+    free(buf);
+    return nullptr;
+}
+
+// Returns the number of pread() workers: one per file in flight, but at
+// most PREAD_THREADS_PER_CPU per online CPU.
+static size pread_workers(const Ingest *in) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const size max = (cpus > 0 ? (size)cpus : 1) * PREAD_THREADS_PER_CPU;
+    size workers = in->n < in->queue_depth ? in->n : in->queue_depth;
+    return workers < max ? workers : max;
+}
+
+static Result ingest_pread(Ingest *in) {
+    in->stats.backend = HELLOC_INGEST_PREAD;
+    atomic_init(&in->next_file, 0);
+    const int rc = pthread_mutex_init(&in->lock, nullptr);
+    if (rc != 0) {
+        errno = rc;
+        return E_IO_FAILED;
+    }
+    // The calling thread is one of the workers.
+    const size extra = pread_workers(in) - 1;
+    pthread_t *threads = nullptr;
+    size started = 0;
+    if (extra > 0) {
+        threads = malloc((size_t)extra * sizeof(*threads));
+    }
+    for (size i = 0; threads != nullptr && i < extra; i++) {
+        if (pthread_create(&threads[i], nullptr, pread_worker, in) != 0) {
+            break;
+        }
+        started++;
+    }
+    pread_worker(in);
+    for (size i = 0; i < started; i++) {
+        pthread_join(threads[i], nullptr);
+    }
+    free(threads);
+    pthread_mutex_destroy(&in->lock);
+    Result res = E_SUCCESS;
+    if (atomic_load(&in->next_file) < in->n) {
+        // Every worker failed to allocate its buffer.
+        res = E_MEMORY_ALLOCATION_FAILED;
+    }
+    return res;
+}
+
+//---------------------------------------------------------------------------//
+// io_uring backend
+//---------------------------------------------------------------------------//
+#ifdef HELLOC_HAVE_IO_URING
+
+typedef struct {
+    int fd;
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned to_submit;
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    // Mappings, for ring_close()
+    void *sq_ptr;
+    size_t sq_len;
+    void *cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+} Ring;
+
+typedef enum { SLOT_OPENING, SLOT_READING, SLOT_CLOSING } SlotState;
+
+// A file in flight.  Slot i reads into registered buffer i.
+typedef struct {
+    SlotState state;
+    /// Whether the operation of `state` has been queued and not completed.
+    bool busy;
+    /// The SQ tail when the operation was queued, to tell whether the
+    /// kernel has consumed its SQE.
+    unsigned sqe_seq;
+    size file;
+    int fd;
+    i64 offset;
+} Slot;
+
+static void ring_close(Ring *r) {
+    if (r->sqes != nullptr) {
+        munmap(r->sqes, r->sqes_len);
+    }
+    if (r->cq_ptr != nullptr && r->cq_ptr != r->sq_ptr) {
+        munmap(r->cq_ptr, r->cq_len);
+    }
+    if (r->sq_ptr != nullptr) {
+        munmap(r->sq_ptr, r->sq_len);
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+}
+
+// Returns true if the kernel supports all io_uring operations that we use.
+static bool ring_supports_ops(const Ring *r) {
+    enum { PROBE_OPS = 256 };
+    struct io_uring_probe *probe =
+        calloc(1, sizeof(*probe) + (PROBE_OPS * sizeof(probe->ops[0])));
+    if (probe == nullptr) {
+        return false;
+    }
+    bool ok = syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PROBE,
+                      probe, PROBE_OPS) == 0;
+    const int ops[] = {IORING_OP_OPENAT, IORING_OP_READ_FIXED,
+                       IORING_OP_CLOSE};
+    for (size i = 0; ok && i < COUNTOF(ops); i++) {
+        ok = ops[i] <= probe->last_op &&
+             (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+    free(probe);
+    return ok;
+}
+
+static bool ring_open(Ring *r, unsigned entries) {
+    *r = (Ring){.fd = -1};
+    struct io_uring_params p = {0};
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) {
+        return false;
+    }
+    r->sq_len = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+    r->cq_len = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+    const bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        r->sq_len = r->sq_len > r->cq_len ? r->sq_len : r->cq_len;
+    }
+    r->sq_ptr = mmap(nullptr, r->sq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) {
+        r->sq_ptr = nullptr;
+        ring_close(r);
+        return false;
+    }
+    r->cq_ptr = single_mmap ? r->sq_ptr
+                            : mmap(nullptr, r->cq_len, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, r->fd,
+                                   IORING_OFF_CQ_RING);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(nullptr, r->sqes_len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->cq_ptr == MAP_FAILED || r->sqes == MAP_FAILED) {
+        r->cq_ptr = r->cq_ptr == MAP_FAILED ? nullptr : r->cq_ptr;
+        r->sqes = r->sqes == MAP_FAILED ? nullptr : r->sqes;
+        ring_close(r);
+        return false;
+    }
+    u8 *sq = r->sq_ptr;
+    r->sq_head = (unsigned *)(void *)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned *)(void *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(void *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(void *)(sq + p.sq_off.array);
+    u8 *cq = r->cq_ptr;
+    r->cq_head = (unsigned *)(void *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(void *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(void *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(void *)(cq + p.cq_off.cqes);
+    if (!ring_supports_ops(r)) {
+        ring_close(r);
+        return false;
+    }
+    return true;
+}
+
+// Returns a zeroed SQE for `slot`.  The queue cannot be full, because every
+// slot has at most one operation in flight.  Call ring_push() once the SQE
+// is filled in.
+static struct io_uring_sqe *ring_sqe(Ring *r, size slot) {
+    const unsigned tail = *r->sq_tail;
+    const unsigned index = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (u64)slot;
+    r->sq_array[index] = index;
+    return sqe;
+}
+
+static void ring_push(Ring *r) {
+    // Publish the SQE to the kernel only after it has been filled in.
+    __atomic_store_n(r->sq_tail, *r->sq_tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+}
+
+// Submits the queued SQEs and waits for at least one completion.
+static bool ring_submit_and_wait(Ring *r) {
+    for (;;) {
+        const long submitted =
+            syscall(__NR_io_uring_enter, r->fd, r->to_submit, 1,
+                    IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (submitted >= 0) {
+            r->to_submit -= (unsigned)submitted;
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+typedef struct {
+    Ingest *in;
+    Ring ring;
+    Slot *slots;
+    u8 *buffers;
+    size next_file;
+    size active;
+} Uring;
+
+static u8 *slot_buffer(const Uring *u, size slot) {
+    return u->buffers + (slot * u->in->buffer_size);
+}
+
+// Returns the SQE for the next operation of the slot.
+static struct io_uring_sqe *slot_sqe(Uring *u, size slot) {
+    Slot *s = &u->slots[slot];
+    s->busy = true;
+    s->sqe_seq = *u->ring.sq_tail;
+    return ring_sqe(&u->ring, slot);
+}
+
+// Returns true if the kernel has not consumed the SQE of the busy slot, so
+// its operation will never run once the ring is closed.
+static bool slot_unsubmitted(const Uring *u, size slot) {
+    const unsigned head = __atomic_load_n(u->ring.sq_head, __ATOMIC_ACQUIRE);
+    return u->slots[slot].sqe_seq - head < *u->ring.sq_tail - head;
+}
+
+static void queue_open(Uring *u, size slot) {
+    Slot *s = &u->slots[slot];
+    if (u->next_file >= u->in->n) {
+        u->active--;
+        return;
+    }
+    *s = (Slot){.state = SLOT_OPENING, .file = u->next_file++, .fd = -1};
+    struct io_uring_sqe *sqe = slot_sqe(u, slot);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (u64)(uptr)u->in->paths[s->file];
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    ring_push(&u->ring);
+}
+
+static void queue_read(Uring *u, size slot) {
+    Slot *s = &u->slots[slot];
+    s->state = SLOT_READING;
+    struct io_uring_sqe *sqe = slot_sqe(u, slot);
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = s->fd;
+    sqe->addr = (u64)(uptr)slot_buffer(u, slot);
+    sqe->len = (u32)u->in->buffer_size;
+    sqe->off = (u64)s->offset;
+    sqe->buf_index = (u16)slot;
+    ring_push(&u->ring);
+}
+
+static void queue_close(Uring *u, size slot) {
+    Slot *s = &u->slots[slot];
+    s->state = SLOT_CLOSING;
+    struct io_uring_sqe *sqe = slot_sqe(u, slot);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = s->fd;
+    ring_push(&u->ring);
+}
+
+static void on_completion(Uring *u, size slot, int res) {
+    Slot *s = &u->slots[slot];
+    s->busy = false;
+    switch (s->state) {
+    case SLOT_OPENING:
+        if (res < 0) {
+            deliver(u->in, s->file, 0, (s8){0}, true, -res);
+            queue_open(u, slot);
+        } else {
+            s->fd = res;
+            queue_read(u, slot);
+        }
+        break;
+    case SLOT_READING:
+        if (res == -EINTR || res == -EAGAIN) {
+            queue_read(u, slot);
+        } else if (res < 0) {
+            deliver(u->in, s->file, s->offset, (s8){0}, true, -res);
+            queue_close(u, slot);
+        } else {
+            const bool eof = res < u->in->buffer_size;
+            deliver(u->in, s->file, s->offset, (s8){slot_buffer(u, slot), res},
+                    eof, 0);
+            s->offset += res;
+            if (eof) {
+                queue_close(u, slot);
+            } else {
+                queue_read(u, slot);
+            }
+        }
+        break;
+    case SLOT_CLOSING:
+        s->fd = -1;
+        queue_open(u, slot);
+        break;
+    }
+}
+
+// Passes the available completions to fn.
+static void reap(Uring *u, void (*fn)(Uring *, size, int)) {
+    unsigned head = *u->ring.cq_head;
+    const unsigned tail = __atomic_load_n(u->ring.cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &u->ring.cqes[head & *u->ring.cq_mask];
+        fn(u, (size)cqe->user_data, cqe->res);
+    }
+    __atomic_store_n(u->ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Completes an operation after a failure without queueing the next one.  An
+// open that succeeds anyway returns a file descriptor that must be closed.
+static void on_abort(Uring *u, size slot, int res) {
+    Slot *s = &u->slots[slot];
+    s->busy = false;
+    if (s->state == SLOT_OPENING && res >= 0) {
+        close(res);
+    }
+}
+
+static bool any_busy(const Uring *u, size depth) {
+    for (size i = 0; i < depth; i++) {
+        if (u->slots[i].busy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Waits for the operations in flight after io_uring_enter() failed, so that
+// no open completes after the ring is closed and leaks its file descriptor.
+// Then closes the files that are still open.
+static void abort_slots(Uring *u, size depth) {
+    // The wait may fail again, e.g. with EBUSY until the completions are
+    // reaped, so give up only if it fails twice without progress.
+    int failures = 0;
+    while (failures < 2 && any_busy(u, depth)) {
+        reap(u, on_abort);
+        if (!any_busy(u, depth)) {
+            break;
+        }
+        failures = ring_submit_and_wait(&u->ring) ? 0 : failures + 1;
+    }
+    // A close that the kernel has consumed but not completed may already
+    // have released the descriptor for reuse, so it is leaked rather than
+    // closed twice.
+    for (size i = 0; i < depth; i++) {
+        const Slot *s = &u->slots[i];
+        if (s->state == SLOT_READING ||
+            (s->state == SLOT_CLOSING && s->busy && slot_unsubmitted(u, i))) {
+            close(s->fd);
+        }
+    }
+}
+
+// Returns E_SUCCESS if all files were read, E_IO_FAILED if io_uring failed,
+// or E_INVALID_INPUT if io_uring is not usable, in which case no file has
+// been touched yet.
+static Result ingest_io_uring(Ingest *in) {
+    const size depth = in->n < in->queue_depth ? in->n : in->queue_depth;
+    if (in->buffer_size > UINT32_MAX || depth > UINT16_MAX) {
+        return E_INVALID_INPUT;
+    }
+    Uring u = {.in = in, .active = depth};
+    if (!ring_open(&u.ring, (unsigned)depth)) {
+        return E_INVALID_INPUT;
+    }
+    Result res = E_INVALID_INPUT;
+    u.slots = calloc((size_t)depth, sizeof(*u.slots));
+    u.buffers = malloc((size_t)(depth * in->buffer_size));
+    struct iovec *iovs = calloc((size_t)depth, sizeof(*iovs));
+    if (u.slots == nullptr || u.buffers == nullptr || iovs == nullptr) {
+        res = E_MEMORY_ALLOCATION_FAILED;
+        goto done;
+    }
+    for (size i = 0; i < depth; i++) {
+        iovs[i] = (struct iovec){slot_buffer(&u, i), (size_t)in->buffer_size};
+    }
+    // Registering pins the buffers once, instead of on every read.  It may
+    // fail because of RLIMIT_MEMLOCK.
+    if (syscall(__NR_io_uring_register, u.ring.fd, IORING_REGISTER_BUFFERS,
+                iovs, (unsigned)depth) != 0) {
+        goto done;
+    }
+    in->stats.backend = HELLOC_INGEST_IO_URING;
+    for (size i = 0; i < depth; i++) {
+        queue_open(&u, i);
+    }
+    res = E_SUCCESS;
+    while (u.active > 0) {
+        if (!ring_submit_and_wait(&u.ring)) {
+            res = E_IO_FAILED;
+            break;
+        }
+        reap(&u, on_completion);
+    }
+    if (res == E_IO_FAILED) {
+        abort_slots(&u, depth);
+    }
+
+done:
+    ring_close(&u.ring);
+    free(iovs);
+    free(u.buffers);
+    free(u.slots);
+    return res;
+}
+
+#endif // HELLOC_HAVE_IO_URING
+
+//---------------------------------------------------------------------------//
+// Public API
+//---------------------------------------------------------------------------//
+
+Result helloc_ingest_files(const char *const *paths, size n,
+                           const HellocIngestOptions *opts, HellocIngestFn fn,
+                           void *ctx, HellocIngestStats *stats) {
+    const HellocIngestOptions o = opts != nullptr ? *opts
+                                                  : (HellocIngestOptions){0};
+    if (paths == nullptr || fn == nullptr || n < 0 || o.queue_depth < 0 ||
+        o.buffer_size < 0) {
+        return E_INVALID_INPUT;
+    }
+    Ingest in = {
+        .paths = paths,
+        .n = n,
+        .queue_depth = o.queue_depth > 0 ? o.queue_depth
+                                         : HELLOC_INGEST_DEFAULT_QUEUE_DEPTH,
+        .buffer_size = o.buffer_size > 0 ? o.buffer_size
+                                         : HELLOC_INGEST_DEFAULT_BUFFER_SIZE,
+        .fn = fn,
+        .ctx = ctx,
+        .stats = {.backend = HELLOC_INGEST_PREAD},
+    };
+    Result res = E_SUCCESS;
+    if (n > 0) {
+        res = E_INVALID_INPUT;
+#ifdef HELLOC_HAVE_IO_URING
+        if (!o.force_pread) {
+            res = ingest_io_uring(&in);
+        }
+#endif
+        if (res == E_INVALID_INPUT) {
+            res = ingest_pread(&in);
+        }
+    }
+    if (stats != nullptr) {
+        *stats = in.stats;
+    }
+    return res;
+}
@@ -0,0 +1,121 @@
+/// @file helloc_ingest.h
+/// @brief Reads many files concurrently and hands their contents over as s8
+/// chunks.
+///
+/// On Linux, files are opened, read and closed through io_uring, with up to
+/// `queue_depth` files in flight at once and one registered buffer per file
+/// in flight, so no time is spent waiting on individual syscalls.  Where
+/// io_uring is not available (older kernels, other operating systems, or
+/// sandboxes that block it), a pool of `queue_depth` threads reads the files
+/// with pread() instead.
+///
+/// Example:
+///
+/// ```
+/// static void on_chunk(void *ctx, const HellocIngestChunk *chunk) {
+///     size *total = ctx;
+///     *total += chunk->data.len;
+/// }
+///
+/// const char *paths[] = {"a.txt", "b.txt"};
+/// size total = 0;
+/// Result res = helloc_ingest_files(paths, 2, NULL, on_chunk, &total, NULL);
+/// ```
+
+// Inclusion guard
+#ifndef HELLOC_INGEST_H
+#define HELLOC_INGEST_H
+
+#include <stdbool.h>
+
+#include "helloc.h"
+
+/// Number of files in flight if HellocIngestOptions.queue_depth is 0.
+#define HELLOC_INGEST_DEFAULT_QUEUE_DEPTH 32
+/// Size of each read buffer if HellocIngestOptions.buffer_size is 0.
+#define HELLOC_INGEST_DEFAULT_BUFFER_SIZE (64 * 1024)
+
+/// @brief Options of helloc_ingest_files().  Zero values select the
+/// defaults.
+typedef struct {
+    /// Number of files that are read concurrently: the io_uring queue depth,
+    /// or the number of threads of the pread() fallback.  The fallback uses
+    /// at most 4 threads per online CPU, however large the queue depth.
+    int queue_depth;
+    /// Size of each read buffer, i.e., the maximum length of a chunk.  Files
+    /// that are not larger than this are delivered in a single chunk.
+    size buffer_size;
+    /// Use the pread() fallback even if io_uring is available.
+    bool force_pread;
+} HellocIngestOptions;
+
+/// @brief A piece of a file that was read by helloc_ingest_files().
+typedef struct {
+    /// The index of the file in the paths array.
+    size file;
+    /// The offset of data within the file.
+    i64 offset;
+    /// The bytes that were read.  Only valid during the callback.
+    s8 data;
+    /// True for the last chunk of the file.
+    bool eof;
+    /// 0 if successful, otherwise the errno of the failed open or read, in
+    /// which case data is empty and eof is true.
+    int error;
+} HellocIngestChunk;
+
+/// @brief Receives the chunks of helloc_ingest_files().
+///
+/// The chunks of a file arrive in order, but the chunks of different files
+/// are interleaved.  The callback is never called concurrently, but it may
+/// be called from threads other than the caller's.
+typedef void (*HellocIngestFn)(void *ctx, const HellocIngestChunk *chunk);
+
+/// @brief Identifies how helloc_ingest_files() read the files.
+typedef enum {
+    HELLOC_INGEST_IO_URING,
+    HELLOC_INGEST_PREAD
+} HellocIngestBackend;
+
+/// @brief Statistics of a helloc_ingest_files() call.
+typedef struct {
+    HellocIngestBackend backend;
+    /// Number of files that could not be opened or read.
+    size files_failed;
+    /// Total number of bytes read.
+    i64 bytes;
+} HellocIngestStats;
+
+/// @brief Reads the files concurrently and calls fn for each chunk.
+///
+/// A read that returns fewer bytes than the buffer size is treated as the
+/// end of the file, which holds for regular files.
+///
+/// @param[in] paths The paths of the files.  They must stay valid until the
+/// function returns.
+/// @param[in] n The number of paths.
+/// @param[in] opts The options, or NULL for the defaults.
+/// @param[in] fn The callback that receives the chunks.  Must not be NULL.
+/// @param[in] ctx Passed to fn as is.
+/// @param[out] stats Stores statistics about the call.  May be NULL.
+///
+/// @returns E_SUCCESS if all files were processed, even if some of them
+/// could not be read (see HellocIngestChunk.error).
+/// @returns E_INVALID_INPUT if paths or fn is NULL, n is negative, or an
+/// option is negative.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+/// @returns E_IO_FAILED if io_uring failed after some files were read, or
+/// if the pread() fallback could not create its lock; errno describes the
+/// error.
+Result helloc_ingest_files(const char *const *paths, size n,
+                           const HellocIngestOptions *opts, HellocIngestFn fn,
+                           void *ctx, HellocIngestStats *stats);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define ingest_files helloc_ingest_files
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_INGEST_H
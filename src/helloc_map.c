@@ -0,0 +1,449 @@
+/// @file helloc_map.c
+/// @brief Implementation of the hash map.
+
+#include "helloc_map.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helloc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Control byte values.  Full slots store the 7-bit H2 hash, i.e. a value in
+// the range [0, 127], so that the high bit marks EMPTY and DELETED slots.
+enum { CTRL_EMPTY = 0x80, CTRL_DELETED = 0xFE };
+
+enum {
+    // Capacity of a new, non-empty table.
+    MIN_CAPACITY = 16,
+    // Number of old slots that each insert or remove moves to the new table
+    // while a resize is in progress.  Must be large enough that the old
+    // table is drained before the new one reaches its maximum load.
+    MIGRATE_BATCH = 16,
+};
+
+//---------------------------------------------------------------------------//
+// Group probing
+//
+// The match functions return a bitmask with one set "lane" per matching
+// control byte in the group.  A lane is 1 bit wide for SSE2 and 8 bits wide
+// for SWAR, so the slot offset is `ctz(mask) >> MASK_SHIFT`.
+//---------------------------------------------------------------------------//
+#if defined(__SSE2__)
+
+#define GROUP_WIDTH 16
+#define MASK_SHIFT 0
+
+static inline __m128i group_load(const u8 *ctrl) {
+    return _mm_load_si128((const __m128i *)(const void *)ctrl);
+}
+
+static inline u64 group_match(const u8 *ctrl, u8 h2) {
+    __m128i g = group_load(ctrl);
+    return (u64)(u32)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(g, _mm_set1_epi8((char)h2)));
+}
+
+static inline u64 group_match_empty(const u8 *ctrl) {
+    return group_match(ctrl, CTRL_EMPTY);
+}
+
+static inline u64 group_match_empty_or_deleted(const u8 *ctrl) {
+    return (u64)(u32)_mm_movemask_epi8(group_load(ctrl));
+}
+
+#else
+
+#define GROUP_WIDTH 8
+#define MASK_SHIFT 3
+
+static const u64 kLsbs = 0x0101010101010101U;
+static const u64 kMsbs = 0x8080808080808080U;
+
+static inline u64 group_load(const u8 *ctrl) {
+    u64 g = 0;
+    memcpy(&g, ctrl, sizeof(g));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    g = __builtin_bswap64(g);
+#endif
+    return g;
+}
+
+// May report false positives when a byte follows a true match, which is
+// harmless because every match is confirmed by comparing the keys.
+static inline u64 group_match(const u8 *ctrl, u8 h2) {
+    u64 x = group_load(ctrl) ^ (kLsbs * h2);
+    return (x - kLsbs) & ~x & kMsbs;
+}
+
+// EMPTY (0x80) is the only control byte with the high bit set and bit 6
+// cleared.
+static inline u64 group_match_empty(const u8 *ctrl) {
+    u64 g = group_load(ctrl);
+    return g & ~(g << 1) & kMsbs;
+}
+
+static inline u64 group_match_empty_or_deleted(const u8 *ctrl) {
+    return group_load(ctrl) & kMsbs;
+}
+
+#endif
+
+static inline size mask_lowest(u64 mask) {
+    return (size)(__builtin_ctzll(mask) >> MASK_SHIFT);
+}
+
+//---------------------------------------------------------------------------//
+// Hashing and keys
+//---------------------------------------------------------------------------//
+
+static inline u64 read64(const u8 *p) {
+    u64 v = 0;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u64 read32(const u8 *p) {
+    u32 v = 0;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u64 hash_mix(u64 h) {
+    h *= 0x9E3779B97F4A7C15U;
+    return h ^ (h >> 32);
+}
+
+// Reads the key with fixed-size loads only, overlapping the last load with
+// the previous one instead of copying a variable-length tail, in the style
+// of wyhash.
+static u64 hash_key(s8 key) {
+    const u8 *p = key.data;
+    size n = key.len;
+    u64 h = 0x243F6A8885A308D3U ^ (u64)n;
+    if (n > 8) {
+        for (; n > 8; n -= 8, p += 8) {
+            h = hash_mix(h ^ read64(p));
+        }
+        h = hash_mix(h ^ read64(p + n - 8));
+    } else if (n == 8) {
+        h = hash_mix(h ^ read64(p));
+    } else if (n >= 4) {
+        h = hash_mix(h ^ ((read32(p) << 32) | read32(p + n - 4)));
+    } else if (n > 0) {
+        h = hash_mix(h ^ (((u64)p[0] << 16) | ((u64)p[n / 2] << 8) |
+                          (u64)p[n - 1]));
+    }
+    // Final avalanche, so that both H1 and H2 depend on all input bits.
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9U;
+    return h ^ (h >> 32);
+}
+
+static inline u8 hash_h2(u64 hash) { return (u8)(hash & 0x7F); }
+
+static inline size slot_key_len(const HellocMapSlot *slot) {
+    return (size)slot->key.inl.len;
+}
+
+static inline const u8 *slot_key(const HellocMapSlot *slot) {
+    return slot_key_len(slot) <= HELLOC_MAP_INLINE_KEY_LEN
+               ? slot->key.inl.bytes
+               : slot->key.ext.ptr;
+}
+
+static inline bool slot_key_equals(const HellocMapSlot *slot, s8 key) {
+    return slot_key_len(slot) == key.len &&
+           (key.len == 0 ||
+            memcmp(slot_key(slot), key.data, (size_t)key.len) == 0);
+}
+
+static Result slot_init(HellocMapSlot *slot, s8 key, void *value) {
+    if (key.len <= HELLOC_MAP_INLINE_KEY_LEN) {
+        memset(slot->key.inl.bytes, 0, sizeof(slot->key.inl.bytes));
+        if (key.len > 0) {
+            memcpy(slot->key.inl.bytes, key.data, (size_t)key.len);
+        }
+        slot->key.inl.len = (u32)key.len;
+    } else {
+        slot->key.ext.ptr = malloc((size_t)key.len);
+        if (slot->key.ext.ptr == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        memcpy(slot->key.ext.ptr, key.data, (size_t)key.len);
+        slot->key.ext.len = (u32)key.len;
+    }
+    slot->value = value;
+    return E_SUCCESS;
+}
+
+static void slot_release(HellocMapSlot *slot) {
+    if (slot_key_len(slot) > HELLOC_MAP_INLINE_KEY_LEN) {
+        free(slot->key.ext.ptr);
+    }
+}
+
+static inline bool key_is_valid(s8 key) {
+    return key.len >= 0 && key.len <= (size)UINT32_MAX &&
+           (key.data != nullptr || key.len == 0);
+}
+
+//---------------------------------------------------------------------------//
+// Tables
+//---------------------------------------------------------------------------//
+
+static Result table_alloc(HellocMapTable *t, size cap) {
+    t->ctrl = aligned_alloc(GROUP_WIDTH, (size_t)cap);
+    t->slots = malloc((size_t)cap * sizeof(HellocMapSlot));
+    if (t->ctrl == nullptr || t->slots == nullptr) {
+        free(t->ctrl);
+        free(t->slots);
+        *t = (HellocMapTable){0};
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    memset(t->ctrl, CTRL_EMPTY, (size_t)cap);
+    t->cap = cap;
+    t->len = 0;
+    t->growth_left = cap - (cap / 8);
+    return E_SUCCESS;
+}
+
+// Releases the arrays of the table, but not the keys stored in it.
+static void table_release(HellocMapTable *t) {
+    free(t->ctrl);
+    free(t->slots);
+    *t = (HellocMapTable){0};
+}
+
+// Returns the slot index of the key, or -1 if the table does not contain it.
+static size table_find(const HellocMapTable *t, s8 key, u64 hash) {
+    if (t->cap == 0) {
+        return -1;
+    }
+    const u8 h2 = hash_h2(hash);
+    const size group_mask = (t->cap / GROUP_WIDTH) - 1;
+    size group = (size)(hash >> 7) & group_mask;
+    // Triangular probing over groups visits every group exactly once because
+    // the number of groups is a power of two.  The load factor guarantees an
+    // EMPTY slot somewhere, so the loop terminates.
+    for (size i = 1;; i++) {
+        const size base = group * GROUP_WIDTH;
+        const u8 *ctrl = t->ctrl + base;
+        for (u64 m = group_match(ctrl, h2); m != 0; m &= m - 1) {
+            const size idx = base + mask_lowest(m);
+            if (slot_key_equals(&t->slots[idx], key)) {
+                return idx;
+            }
+        }
+        if (group_match_empty(ctrl) != 0) {
+            return -1;
+        }
+        group = (group + i) & group_mask;
+    }
+}
+
+// Returns the first EMPTY or DELETED slot on the probe sequence of the hash.
+static size table_find_free(const HellocMapTable *t, u64 hash) {
+    const size group_mask = (t->cap / GROUP_WIDTH) - 1;
+    size group = (size)(hash >> 7) & group_mask;
+    for (size i = 1;; i++) {
+        const size base = group * GROUP_WIDTH;
+        const u64 m = group_match_empty_or_deleted(t->ctrl + base);
+        if (m != 0) {
+            return base + mask_lowest(m);
+        }
+        group = (group + i) & group_mask;
+    }
+}
+
+// Adds an entry whose key is known to be absent from the table, taking over
+// the slot's key storage.  The table must have growth_left > 0.
+static void table_insert_new(HellocMapTable *t, const HellocMapSlot *slot,
+                             u64 hash) {
+    const size idx = table_find_free(t, hash);
+    if (t->ctrl[idx] == CTRL_EMPTY) {
+        t->growth_left--;
+    }
+    t->ctrl[idx] = hash_h2(hash);
+    t->slots[idx] = *slot;
+    t->len++;
+}
+
+static void table_erase(HellocMapTable *t, size idx) {
+    // A group that still has an EMPTY slot has never been full, so no probe
+    // sequence continues past it and the slot can become EMPTY again.
+    // Otherwise a DELETED tombstone keeps the probe sequences intact.
+    const size base = idx & ~(size)(GROUP_WIDTH - 1);
+    if (group_match_empty(t->ctrl + base) != 0) {
+        t->ctrl[idx] = CTRL_EMPTY;
+        t->growth_left++;
+    } else {
+        t->ctrl[idx] = CTRL_DELETED;
+    }
+    t->len--;
+}
+
+//---------------------------------------------------------------------------//
+// Incremental resizing
+//---------------------------------------------------------------------------//
+
+// Moves up to `budget` slots of the old table to the current table.
+static void migrate(HellocMap *m, size budget) {
+    if (m->old.cap == 0) {
+        return;
+    }
+    HellocMapTable *old = &m->old;
+    const size end = m->migrate_pos + budget < old->cap
+                         ? m->migrate_pos + budget
+                         : old->cap;
+    for (size i = m->migrate_pos; i < end; i++) {
+        if ((old->ctrl[i] & CTRL_EMPTY) == 0) {
+            const HellocMapSlot *slot = &old->slots[i];
+            const s8 key = {(u8 *)slot_key(slot), slot_key_len(slot)};
+            table_insert_new(&m->cur, slot, hash_key(key));
+            // Lookups that still probe the old table must not find it.
+            old->ctrl[i] = CTRL_DELETED;
+            old->len--;
+        }
+    }
+    m->migrate_pos = end;
+    if (end == old->cap) {
+        table_release(old);
+        m->migrate_pos = 0;
+    }
+}
+
+// Replaces the current table with a new one and starts moving the entries
+// over.  Only called when the current table has no growth left.
+static Result grow(HellocMap *m) {
+    // Finish a resize that is still in progress first.
+    migrate(m, m->old.cap);
+    if (m->cur.growth_left > 0) {
+        return E_SUCCESS;
+    }
+    // Double the capacity, unless most of the used slots are tombstones, in
+    // which case a table of the same capacity suffices.
+    size new_cap = MIN_CAPACITY;
+    if (m->cur.cap > 0) {
+        new_cap = m->cur.len >= m->cur.cap / 2 ? m->cur.cap * 2 : m->cur.cap;
+    }
+    HellocMapTable t = {0};
+    Result res = table_alloc(&t, new_cap);
+    if (res != E_SUCCESS) {
+        return res;
+    }
+    if (m->cur.cap == 0) {
+        m->cur = t;
+    } else {
+        m->old = m->cur;
+        m->cur = t;
+        m->migrate_pos = 0;
+    }
+    return E_SUCCESS;
+}
+
+//---------------------------------------------------------------------------//
+// Public API
+//---------------------------------------------------------------------------//
+
+void helloc_map_init(HellocMap *m) { *m = (HellocMap){0}; }
+
+static void free_table(HellocMapTable *t) {
+    for (size i = 0; i < t->cap; i++) {
+        if ((t->ctrl[i] & CTRL_EMPTY) == 0) {
+            slot_release(&t->slots[i]);
+        }
+    }
+    table_release(t);
+}
+
+void helloc_map_free(HellocMap *m) {
+    if (m == nullptr) {
+        return;
+    }
+    free_table(&m->cur);
+    free_table(&m->old);
+    helloc_map_init(m);
+}
+
+size helloc_map_len(const HellocMap *m) { return m->cur.len + m->old.len; }
+
+Result helloc_map_put(HellocMap *m, s8 key, void *value) {
+    if (m == nullptr || !key_is_valid(key)) {
+        return E_INVALID_INPUT;
+    }
+    migrate(m, MIGRATE_BATCH);
+    const u64 hash = hash_key(key);
+    size idx = table_find(&m->cur, key, hash);
+    if (idx >= 0) {
+        m->cur.slots[idx].value = value;
+        return E_SUCCESS;
+    }
+    idx = table_find(&m->old, key, hash);
+    if (idx >= 0) {
+        // Updated in place; the entry moves to the new table later.
+        m->old.slots[idx].value = value;
+        return E_SUCCESS;
+    }
+    if (m->cur.growth_left == 0) {
+        Result res = grow(m);
+        if (res != E_SUCCESS) {
+            return res;
+        }
+    }
+    HellocMapSlot slot;
+    Result res = slot_init(&slot, key, value);
+    if (res != E_SUCCESS) {
+        return res;
+    }
+    table_insert_new(&m->cur, &slot, hash);
+    return E_SUCCESS;
+}
+
+bool helloc_map_get(const HellocMap *m, s8 key, void **value) {
+    if (m == nullptr || !key_is_valid(key)) {
+        return false;
+    }
+    const u64 hash = hash_key(key);
+    const HellocMapTable *t = &m->cur;
+    size idx = table_find(t, key, hash);
+    if (idx < 0) {
+        t = &m->old;
+        idx = table_find(t, key, hash);
+    }
+    if (idx < 0) {
+        return false;
+    }
+    if (value != nullptr) {
+        *value = t->slots[idx].value;
+    }
+    return true;
+}
+
+bool helloc_map_remove(HellocMap *m, s8 key, void **value) {
+    if (m == nullptr || !key_is_valid(key)) {
+        return false;
+    }
+    migrate(m, MIGRATE_BATCH);
+    const u64 hash = hash_key(key);
+    HellocMapTable *t = &m->cur;
+    size idx = table_find(t, key, hash);
+    if (idx < 0) {
+        t = &m->old;
+        idx = table_find(t, key, hash);
+    }
+    if (idx < 0) {
+        return false;
+    }
+    if (value != nullptr) {
+        *value = t->slots[idx].value;
+    }
+    slot_release(&t->slots[idx]);
+    table_erase(t, idx);
+    return true;
+}
@@ -0,0 +1,148 @@
+/// @file helloc_map.h
+/// @brief Provides a hash map from s8 strings to pointers.
+///
+/// The map is an open-addressing hash table in the style of Abseil's "Swiss
+/// tables":
+///
+/// * Each slot has a one-byte control byte that is either EMPTY, DELETED, or
+///   the low 7 bits of the key's hash.  Control bytes are probed a group at a
+///   time (16 slots with SSE2, 8 slots with a portable SWAR fallback), so a
+///   lookup usually compares a single key.
+/// * Keys of up to HELLOC_MAP_INLINE_KEY_LEN bytes are stored inline in the
+///   32-byte slot, which avoids a pointer dereference and an allocation per
+///   key.  Longer keys are copied to the heap.  The map owns all its key
+///   copies.
+/// * When the map grows, entries are moved to the new table incrementally by
+///   subsequent insert and remove operations rather than all at once, so no
+///   single operation pays for rehashing the whole map.
+
+// Inclusion guard
+#ifndef HELLOC_MAP_H
+#define HELLOC_MAP_H
+
+#include <stdbool.h>
+
+#include "helloc.h"
+
+/// Keys up to this length (in bytes) are stored inline in the slot.
+#define HELLOC_MAP_INLINE_KEY_LEN 20
+
+/// @brief A slot of the hash map that holds one key-value pair.
+///
+/// Both key representations start with the key length, so `key.inl.len` is
+/// valid for either of them.
+typedef struct {
+    union {
+        /// Used when len <= HELLOC_MAP_INLINE_KEY_LEN.
+        struct {
+            u32 len;
+            u8 bytes[HELLOC_MAP_INLINE_KEY_LEN];
+        } inl;
+        /// Used for longer keys.  The map owns the heap-allocated bytes.
+        struct {
+            u32 len;
+            u8 *ptr;
+        } ext;
+    } key;
+    void *value;
+} HellocMapSlot;
+static_assert(sizeof(HellocMapSlot) == 32, "slot must be 32 bytes");
+
+/// @brief A single open-addressing table of a HellocMap.
+typedef struct {
+    /// One control byte per slot.
+    u8 *ctrl;
+    HellocMapSlot *slots;
+    /// Number of slots, a power of two, or 0 if nothing was allocated yet.
+    size cap;
+    /// Number of entries in this table.
+    size len;
+    /// Number of entries that can still be added to EMPTY slots before the
+    /// maximum load factor (7/8) is reached.
+    size growth_left;
+} HellocMapTable;
+
+/// @brief A hash map from s8 strings to pointers.
+///
+/// A zero-initialized HellocMap is a valid, empty map.
+typedef struct {
+    /// The table to which new entries are added.
+    HellocMapTable cur;
+    /// The previous table while a resize is in progress, zeroed otherwise.
+    HellocMapTable old;
+    /// The next slot of `old` that will be moved to `cur`.
+    size migrate_pos;
+} HellocMap;
+
+/// @brief Initializes an empty map.
+///
+/// @param[out] m The map to initialize.  Must not be NULL.
+void helloc_map_init(HellocMap *m);
+
+/// @brief Releases all memory of the map and resets it to an empty map.
+///
+/// The values are not freed.
+///
+/// @param[in,out] m The map to free.  NULL is a no-op.
+void helloc_map_free(HellocMap *m);
+
+/// @brief Returns the number of entries in the map.
+size helloc_map_len(const HellocMap *m);
+
+/// @brief Inserts the key-value pair, or updates the value if the key exists.
+///
+/// The map stores a copy of the key, so the caller keeps ownership of the
+/// key's data.
+///
+/// Example:
+///
+/// ```
+/// HellocMap m;
+/// helloc_map_init(&m);
+/// int answer = 42;
+/// Result res = helloc_map_put(&m, s8("answer"), &answer);
+/// helloc_map_free(&m);
+/// ```
+///
+/// @param[in,out] m The map.  Must not be NULL.
+/// @param[in] key The key.
+/// @param[in] value The value.  May be NULL.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if m is NULL, or if key is invalid or longer
+/// than UINT32_MAX bytes.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_map_put(HellocMap *m, s8 key, void *value);
+
+/// @brief Looks up the value for the key.
+///
+/// @param[in] m The map.  Must not be NULL.
+/// @param[in] key The key.
+/// @param[out] value Stores the value if the key was found.  May be NULL.
+///
+/// @returns true if the key was found, false otherwise.
+bool helloc_map_get(const HellocMap *m, s8 key, void **value);
+
+/// @brief Removes the key and its value from the map.
+///
+/// @param[in,out] m The map.  Must not be NULL.
+/// @param[in] key The key.
+/// @param[out] value Stores the removed value if the key was found.  May be
+/// NULL.
+///
+/// @returns true if the key was found and removed, false otherwise.
+bool helloc_map_remove(HellocMap *m, s8 key, void **value);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define map_init helloc_map_init
+#define map_free helloc_map_free
+#define map_len helloc_map_len
+#define map_put helloc_map_put
+#define map_get helloc_map_get
+#define map_remove helloc_map_remove
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_MAP_H
@@ -0,0 +1,207 @@
+/// @file helloc_parser.c
+/// @brief Implementation of the streaming record parser.
+
+#include "helloc_parser.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helloc.h"
+
+enum {
+    // Initial capacity of the carry buffer once a record spans chunks.
+    CARRY_MIN_CAP = 256
+};
+
+// Returns the offset of the first record delimiter in s, or -1.
+static size find_delim(const HellocParser *p, s8 s) {
+    size i = 0;
+    while (i + p->delim_len <= s.len) {
+        const u8 *hit = memchr(s.data + i, p->delim[0],
+                               (size_t)(s.len - i - p->delim_len + 1));
+        if (hit == nullptr) {
+            return -1;
+        }
+        i = hit - s.data;
+        if (memcmp(hit, p->delim, (size_t)p->delim_len) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return -1;
+}
+
+// Returns k > 0 if the carry ends with the first k bytes of the record
+// delimiter and the chunk begins with the rest of it, otherwise 0.  The
+// carry never contains a complete delimiter, so the largest k marks the
+// first delimiter.
+static size find_straddling_delim(const HellocParser *p, s8 chunk) {
+    size k = p->delim_len - 1 < p->carry_len ? p->delim_len - 1 : p->carry_len;
+    for (; k > 0; k--) {
+        const size rest = p->delim_len - k;
+        if (chunk.len >= rest &&
+            memcmp(p->carry + p->carry_len - k, p->delim, (size_t)k) == 0 &&
+            memcmp(chunk.data, p->delim + k, (size_t)rest) == 0) {
+            return k;
+        }
+    }
+    return 0;
+}
+
+static void emit(HellocParser *p, s8 line) {
+    if (line.len == 0) {
+        return;
+    }
+    if (line.len > p->max_record) {
+        p->dropped++;
+        return;
+    }
+    HellocRecord record = {.line = line};
+    record.has_value = helloc_s8_split_once(line, p->field_delim, &record.key,
+                                            &record.value);
+    p->records++;
+    p->fn(p->ctx, &record);
+}
+
+// Drops the incomplete record, but keeps the bytes of the carry and s that
+// might begin a record delimiter.  The carry always has room for them.
+static void skip(HellocParser *p, s8 s) {
+    if (!p->skipping) {
+        p->skipping = true;
+        p->dropped++;
+    }
+    const size total = p->carry_len + s.len;
+    const size keep = p->delim_len - 1 < total ? p->delim_len - 1 : total;
+    if (s.len >= keep) {
+        memcpy(p->carry, s.data + s.len - keep, (size_t)keep);
+    } else {
+        memmove(p->carry, p->carry + p->carry_len - (keep - s.len),
+                (size_t)(keep - s.len));
+        memcpy(p->carry + keep - s.len, s.data, (size_t)s.len);
+    }
+    p->carry_len = keep;
+}
+
+// Appends s to the incomplete record, or skips the record if it gets longer
+// than max_record.  A partial delimiter at the end may exceed max_record.
+static Result carry(HellocParser *p, s8 s) {
+    const size limit = p->max_record + p->delim_len - 1;
+    if (p->skipping || s.len > limit - p->carry_len) {
+        skip(p, s);
+        return E_SUCCESS;
+    }
+    const size need = p->carry_len + s.len;
+    if (need > p->carry_cap) {
+        size new_cap = p->carry_cap > CARRY_MIN_CAP ? p->carry_cap
+                                                    : CARRY_MIN_CAP;
+        while (new_cap < need) {
+            new_cap *= 2;
+        }
+        new_cap = new_cap < limit ? new_cap : limit;
+        u8 *q = realloc(p->carry, (size_t)new_cap);
+        if (q == nullptr) {
+            skip(p, s);
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        p->carry = q;
+        p->carry_cap = new_cap;
+    }
+    if (s.len > 0) {
+        memcpy(p->carry + p->carry_len, s.data, (size_t)s.len);
+    }
+    p->carry_len = need;
+    return E_SUCCESS;
+}
+
+Result helloc_parser_init(HellocParser *p, s8 record_delim, u8 field_delim,
+                          size max_record, HellocRecordFn fn, void *ctx) {
+    if (p == nullptr || record_delim.data == nullptr ||
+        record_delim.len < 1 || record_delim.len > HELLOC_PARSER_DELIM_MAX ||
+        max_record < 0 || max_record > PTRDIFF_MAX / 2 || fn == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    *p = (HellocParser){
+        .delim_len = record_delim.len,
+        .field_delim = field_delim,
+        .max_record =
+            max_record > 0 ? max_record : HELLOC_PARSER_DEFAULT_MAX_RECORD,
+        .fn = fn,
+        .ctx = ctx,
+    };
+    memcpy(p->delim, record_delim.data, (size_t)record_delim.len);
+    // Room for the bytes that skip() keeps, so that skipping never fails.
+    p->carry = malloc(HELLOC_PARSER_DELIM_MAX);
+    if (p->carry == nullptr) {
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    p->carry_cap = HELLOC_PARSER_DELIM_MAX;
+    return E_SUCCESS;
+}
+
+void helloc_parser_free(HellocParser *p) {
+    if (p == nullptr) {
+        return;
+    }
+    free(p->carry);
+    p->carry = nullptr;
+    p->carry_len = 0;
+    p->carry_cap = 0;
+}
+
+Result helloc_parser_feed(HellocParser *p, s8 chunk) {
+    if (p == nullptr || p->carry == nullptr || chunk.len < 0 ||
+        (chunk.data == nullptr && chunk.len > 0)) {
+        return E_INVALID_INPUT;
+    }
+    Result res = E_SUCCESS;
+    while (chunk.len > 0) {
+        s8 line;
+        size consumed;
+        if (p->carry_len == 0 && !p->skipping) {
+            // Fast path: the record starts in this chunk.
+            const size at = find_delim(p, chunk);
+            if (at < 0) {
+                const Result r = carry(p, chunk);
+                return r != E_SUCCESS ? r : res;
+            }
+            line = (s8){chunk.data, at};
+            consumed = at + p->delim_len;
+        } else {
+            // The record continues from the previous chunks.
+            const size k = find_straddling_delim(p, chunk);
+            if (k > 0) {
+                line = (s8){p->carry, p->carry_len - k};
+                consumed = p->delim_len - k;
+            } else {
+                const size at = find_delim(p, chunk);
+                const Result r =
+                    carry(p, (s8){chunk.data, at < 0 ? chunk.len : at});
+                res = r != E_SUCCESS ? r : res;
+                if (at < 0) {
+                    return res;
+                }
+                line = (s8){p->carry, p->carry_len};
+                consumed = at + p->delim_len;
+            }
+            if (p->skipping) {
+                line = (s8){0};
+            }
+            p->carry_len = 0;
+            p->skipping = false;
+        }
+        emit(p, line);
+        chunk.data += consumed;
+        chunk.len -= consumed;
+    }
+    return res;
+}
+
+void helloc_parser_finish(HellocParser *p) {
+    if (!p->skipping) {
+        emit(p, (s8){p->carry, p->carry_len});
+    }
+    p->carry_len = 0;
+    p->skipping = false;
+}
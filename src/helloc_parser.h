@@ -0,0 +1,146 @@
+/// @file helloc_parser.h
+/// @brief Provides a streaming parser for delimited key/value records.
+///
+/// The parser is fed chunks of a stream of arbitrary size, such as the
+/// buffers of read() or the chunks of helloc_ingest_files(), and calls back
+/// with every complete record split into a key and a value, like
+/// helloc_s8_split_once().  Records and record delimiters may be split
+/// across chunks in any way.
+///
+/// Records that lie within a chunk are passed on without copying.  Only the
+/// incomplete record at the end of a chunk is copied, to a buffer of at most
+/// `max_record` bytes (plus the length of the delimiter), so the memory use
+/// does not depend on the length of the stream.  Longer records are dropped
+/// and counted in HellocParser.dropped.
+///
+/// Example:
+///
+/// ```
+/// static void on_record(void *ctx, const HellocRecord *record) {
+///     printf("%.*s -> %.*s\n", (int)record->key.len, record->key.data,
+///            (int)record->value.len, record->value.data);
+/// }
+///
+/// HellocParser p;
+/// helloc_parser_init(&p, s8("\n"), '=', 0, on_record, NULL);
+/// helloc_parser_feed(&p, s8("a=1\nb="));
+/// helloc_parser_feed(&p, s8("2\nc=3")); // a -> 1, b -> 2
+/// helloc_parser_finish(&p);             // c -> 3
+/// helloc_parser_free(&p);
+/// ```
+
+// Inclusion guard
+#ifndef HELLOC_PARSER_H
+#define HELLOC_PARSER_H
+
+#include <stdbool.h>
+
+#include "helloc.h"
+
+/// Maximum length of a record delimiter.
+#define HELLOC_PARSER_DELIM_MAX 8
+/// Maximum length of a record if max_record is 0 in helloc_parser_init().
+#define HELLOC_PARSER_DEFAULT_MAX_RECORD (64 * 1024)
+
+/// @brief A record that was parsed by a HellocParser.
+///
+/// All strings are only valid during the callback.
+typedef struct {
+    /// The whole record, without the record delimiter.
+    s8 line;
+    /// The part of the line before the first field delimiter, or the whole
+    /// line if it has no field delimiter.
+    s8 key;
+    /// The part of the line after the first field delimiter, or an empty
+    /// string with NULL data if it has no field delimiter.
+    s8 value;
+    /// True if the line has a field delimiter.
+    bool has_value;
+} HellocRecord;
+
+/// @brief Receives the records of a HellocParser in stream order.
+typedef void (*HellocRecordFn)(void *ctx, const HellocRecord *record);
+
+/// @brief A streaming parser for delimited key/value records.
+///
+/// Create with helloc_parser_init().
+typedef struct {
+    u8 delim[HELLOC_PARSER_DELIM_MAX];
+    size delim_len;
+    u8 field_delim;
+    size max_record;
+    HellocRecordFn fn;
+    void *ctx;
+    /// The incomplete record at the end of the last chunk.  While skipping
+    /// an oversized record, only its last delim_len - 1 bytes, which might
+    /// begin a delimiter.
+    u8 *carry;
+    size carry_len;
+    size carry_cap;
+    /// True while the rest of an oversized record is being skipped.
+    bool skipping;
+    /// The number of records passed to the callback.
+    size records;
+    /// The number of records that were dropped because they were longer
+    /// than max_record, or because the carry buffer could not grow.
+    size dropped;
+} HellocParser;
+
+/// @brief Initializes a parser.
+///
+/// Empty records, e.g., blank lines, are skipped.
+///
+/// @param[out] p The parser to initialize.  Must not be NULL.
+/// @param[in] record_delim The delimiter between records, e.g., "\n" or
+/// "\r\n", of 1 to HELLOC_PARSER_DELIM_MAX bytes.
+/// @param[in] field_delim The delimiter between the key and the value.
+/// @param[in] max_record The maximum length of a record, or 0 for
+/// HELLOC_PARSER_DEFAULT_MAX_RECORD.
+/// @param[in] fn The callback that receives the records.  Must not be NULL.
+/// @param[in] ctx Passed to fn as is.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if an argument is invalid.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_parser_init(HellocParser *p, s8 record_delim, u8 field_delim,
+                          size max_record, HellocRecordFn fn, void *ctx);
+
+/// @brief Releases the memory of the parser.
+///
+/// @param[in,out] p The parser to free.  NULL is a no-op.
+void helloc_parser_free(HellocParser *p);
+
+/// @brief Parses the next chunk of the stream.
+///
+/// Calls back with every record that is completed by the chunk, and keeps
+/// the incomplete record at its end for the next call.
+///
+/// @param[in,out] p The parser.  Must not be NULL.
+/// @param[in] chunk The next bytes of the stream.  Need not stay valid after
+/// the call.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if p is NULL or chunk is invalid.
+/// @returns E_MEMORY_ALLOCATION_FAILED if an incomplete record could not be
+/// kept.  The record is dropped, and parsing continues with the next one.
+Result helloc_parser_feed(HellocParser *p, s8 chunk);
+
+/// @brief Ends the stream, and calls back with the last record if the
+/// stream does not end with a record delimiter.
+///
+/// The parser can then be fed a new stream.
+///
+/// @param[in,out] p The parser.  Must not be NULL.
+void helloc_parser_finish(HellocParser *p);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define parser_init helloc_parser_init
+#define parser_free helloc_parser_free
+#define parser_feed helloc_parser_feed
+#define parser_finish helloc_parser_finish
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_PARSER_H
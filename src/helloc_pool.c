@@ -0,0 +1,442 @@
+/// @file helloc_pool.c
+/// @brief Implementation of the pool allocator.
+
+#include "helloc_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "helloc.h"
+
+struct HellocPoolPage {
+    HellocPoolPage *next;
+};
+
+struct HellocPoolMagazine {
+    HellocPoolMagazine *prev;
+    HellocPoolMagazine *next;
+    /// NULL once the pool has been freed, guarded by g_orphan_lock.
+    HellocPool *pool;
+    /// Written by the owning thread only, and read by helloc_pool_stats().
+    size count;
+    void *slots[HELLOC_POOL_MAGAZINE_SIZE];
+};
+
+// The magazines of one thread, an open-addressing hash table keyed by pool
+// id.  Id 0 marks an empty entry.
+typedef struct {
+    u64 id;
+    HellocPoolMagazine *magazine;
+} MagazineEntry;
+
+typedef struct {
+    MagazineEntry *entries;
+    size cap; // a power of two
+    size len;
+} MagazineTable;
+
+enum { TABLE_MIN_CAP = 8 };
+
+// Pool ids are never reused, so the entries of freed pools never match.
+static atomic_ullong g_next_pool_id = 1;
+
+// One key for all pools, whose destructor releases the magazines of an
+// exiting thread.  Unlike a key per pool, it does not use up the
+// PTHREAD_KEYS_MAX keys of the process.
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static bool g_key_ok;
+
+// Orders helloc_pool_free() against exiting threads that return their
+// magazines to the pool.
+static pthread_mutex_t g_orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local MagazineTable *t_table;
+// The magazine of the pool that this thread used last, which saves the
+// table lookup in the common case.
+static _Thread_local u64 t_last_pool_id;
+static _Thread_local HellocPoolMagazine *t_last_magazine;
+
+static size round_up(size n, size align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+// The alignment of the pages, which is at least that of malloc().
+static size page_align(const HellocPool *pool) {
+    return pool->align > ALIGNOF(max_align_t) ? pool->align
+                                              : ALIGNOF(max_align_t);
+}
+
+// The offset of the first slot in a page.
+static size first_slot(const HellocPool *pool) {
+    return round_up(SIZEOF(HellocPoolPage), pool->align);
+}
+
+static void set_count(HellocPoolMagazine *m, size count) {
+    __atomic_store_n(&m->count, count, __ATOMIC_RELAXED);
+}
+
+//---------------------------------------------------------------------------//
+// Shared state, guarded by pool->lock
+//---------------------------------------------------------------------------//
+
+// Moves carving to the next empty page, which is allocated if needed.
+static bool next_page(HellocPool *pool) {
+    HellocPoolPage *page =
+        pool->carve_page != nullptr ? pool->carve_page->next : pool->pages;
+    if (page == nullptr) {
+        page = aligned_alloc((size_t)page_align(pool),
+                             (size_t)pool->page_size);
+        if (page == nullptr) {
+            return false;
+        }
+        page->next = nullptr;
+        if (pool->last_page != nullptr) {
+            pool->last_page->next = page;
+        } else {
+            pool->pages = page;
+        }
+        pool->last_page = page;
+        pool->page_count++;
+    }
+    pool->carve_page = page;
+    pool->carve_next = (u8 *)page + first_slot(pool);
+    pool->carve_end = (u8 *)page + pool->page_size;
+    return true;
+}
+
+// Takes a slot from the free list, or carves a new one.
+static void *take_slot(HellocPool *pool) {
+    void *slot = pool->free_list;
+    if (slot != nullptr) {
+        pool->free_list = *(void **)slot;
+        pool->free_count--;
+        return slot;
+    }
+    if (pool->carve_end - pool->carve_next < pool->slot_size &&
+        !next_page(pool)) {
+        return nullptr;
+    }
+    slot = pool->carve_next;
+    pool->carve_next += pool->slot_size;
+    pool->carved++;
+    return slot;
+}
+
+static void put_slot(HellocPool *pool, void *slot) {
+    *(void **)slot = pool->free_list;
+    pool->free_list = slot;
+    pool->free_count++;
+}
+
+//---------------------------------------------------------------------------//
+// Magazines
+//---------------------------------------------------------------------------//
+
+// Returns the slots of the magazine to its pool, unless the pool has been
+// freed, and frees the magazine.
+static void magazine_destroy(HellocPoolMagazine *m) {
+    pthread_mutex_lock(&g_orphan_lock);
+    HellocPool *pool = m->pool;
+    if (pool != nullptr) {
+        pthread_mutex_lock(&pool->lock);
+        for (size i = 0; i < m->count; i++) {
+            put_slot(pool, m->slots[i]);
+        }
+        if (m->prev != nullptr) {
+            m->prev->next = m->next;
+        } else {
+            pool->magazines = m->next;
+        }
+        if (m->next != nullptr) {
+            m->next->prev = m->prev;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    if (t_last_magazine == m) {
+        t_last_pool_id = 0;
+        t_last_magazine = nullptr;
+    }
+    free(m);
+}
+
+static size table_slot(u64 id, size cap) {
+    // Fibonacci hashing spreads the consecutive ids.
+    return (size)((id * 0x9E3779B97F4A7C15U) >> 32) & (cap - 1);
+}
+
+static void table_put(MagazineTable *t, u64 id, HellocPoolMagazine *m) {
+    size i = table_slot(id, t->cap);
+    while (t->entries[i].id != 0) {
+        i = (i + 1) & (t->cap - 1);
+    }
+    t->entries[i] = (MagazineEntry){id, m};
+    t->len++;
+}
+
+static HellocPoolMagazine *table_get(const MagazineTable *t, u64 id) {
+    for (size i = table_slot(id, t->cap); t->entries[i].id != 0;
+         i = (i + 1) & (t->cap - 1)) {
+        if (t->entries[i].id == id) {
+            return t->entries[i].magazine;
+        }
+    }
+    return nullptr;
+}
+
+// Rebuilds the table with room for one more entry.  Drops the magazines of
+// freed pools on the way, so that they do not accumulate.
+static bool table_rebuild(MagazineTable *t) {
+    MagazineEntry *old = t->entries;
+    const size old_cap = t->cap;
+    // Entries of pools that are freed meanwhile only make the table larger.
+    size live = 0;
+    pthread_mutex_lock(&g_orphan_lock);
+    for (size i = 0; i < old_cap; i++) {
+        live += old[i].id != 0 && old[i].magazine->pool != nullptr;
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    size cap = TABLE_MIN_CAP;
+    while ((live + 1) * 2 > cap) {
+        cap *= 2;
+    }
+    MagazineEntry *entries = calloc((size_t)cap, sizeof(*entries));
+    if (entries == nullptr) {
+        return false;
+    }
+    *t = (MagazineTable){.entries = entries, .cap = cap};
+    pthread_mutex_lock(&g_orphan_lock);
+    for (size i = 0; i < old_cap; i++) {
+        if (old[i].id == 0) {
+            continue;
+        }
+        if (old[i].magazine->pool == nullptr) {
+            free(old[i].magazine);
+        } else {
+            table_put(t, old[i].id, old[i].magazine);
+        }
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    free(old);
+    return true;
+}
+
+// Returns the slots of an exiting thread to their pools.
+static void table_destroy(void *arg) {
+    MagazineTable *t = arg;
+    for (size i = 0; i < t->cap; i++) {
+        if (t->entries[i].id != 0) {
+            magazine_destroy(t->entries[i].magazine);
+        }
+    }
+    free(t->entries);
+    free(t);
+    t_table = nullptr;
+}
+
+static void create_key(void) {
+    g_key_ok = pthread_key_create(&g_key, table_destroy) == 0;
+}
+
+static MagazineTable *thread_table(void) {
+    if (t_table == nullptr) {
+        pthread_once(&g_key_once, create_key);
+        MagazineTable *t = calloc(1, sizeof(*t));
+        if (t == nullptr || !g_key_ok || pthread_setspecific(g_key, t) != 0) {
+            free(t);
+            return nullptr;
+        }
+        t_table = t;
+    }
+    return t_table;
+}
+
+static HellocPoolMagazine *magazine_slow(HellocPool *pool) {
+    MagazineTable *t = thread_table();
+    if (t == nullptr) {
+        return nullptr;
+    }
+    HellocPoolMagazine *m = t->cap > 0 ? table_get(t, pool->id) : nullptr;
+    if (m == nullptr) {
+        if ((t->len + 1) * 2 > t->cap && !table_rebuild(t)) {
+            return nullptr;
+        }
+        m = calloc(1, sizeof(*m));
+        if (m == nullptr) {
+            return nullptr;
+        }
+        m->pool = pool;
+        table_put(t, pool->id, m);
+        pthread_mutex_lock(&pool->lock);
+        m->next = pool->magazines;
+        if (m->next != nullptr) {
+            m->next->prev = m;
+        }
+        pool->magazines = m;
+        pthread_mutex_unlock(&pool->lock);
+    }
+    t_last_pool_id = pool->id;
+    t_last_magazine = m;
+    return m;
+}
+
+// Returns the magazine of the calling thread, or NULL if it could not be
+// created, in which case the shared free list is used directly.
+static inline HellocPoolMagazine *magazine(HellocPool *pool) {
+    if (t_last_pool_id == pool->id) {
+        return t_last_magazine;
+    }
+    return magazine_slow(pool);
+}
+
+// Refills half of the empty magazine and returns one more slot.
+static void *alloc_slow(HellocPool *pool, HellocPoolMagazine *m) {
+    pthread_mutex_lock(&pool->lock);
+    void *slot = take_slot(pool);
+    if (m != nullptr && slot != nullptr) {
+        size n = 0;
+        void *s;
+        while (n < HELLOC_POOL_MAGAZINE_SIZE / 2 &&
+               (s = take_slot(pool)) != nullptr) {
+            m->slots[n++] = s;
+        }
+        set_count(m, n);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return slot;
+}
+
+// Returns half of the full magazine to the pool.
+static void release_slow(HellocPool *pool, HellocPoolMagazine *m,
+                         void *obj) {
+    pthread_mutex_lock(&pool->lock);
+    if (m == nullptr) {
+        put_slot(pool, obj);
+    } else {
+        size n = m->count;
+        while (n > HELLOC_POOL_MAGAZINE_SIZE / 2) {
+            put_slot(pool, m->slots[--n]);
+        }
+        m->slots[n++] = obj;
+        set_count(m, n);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+//---------------------------------------------------------------------------//
+// Public API
+//---------------------------------------------------------------------------//
+
+Result helloc_pool_init(HellocPool *pool, size object_size, size align) {
+    if (pool == nullptr || object_size <= 0 || align <= 0 ||
+        (align & (align - 1)) != 0 || object_size > PTRDIFF_MAX / 4 ||
+        align > HELLOC_POOL_PAGE_SIZE) {
+        return E_INVALID_INPUT;
+    }
+    // A free slot holds the link of the free list.
+    *pool = (HellocPool){
+        .align = align > ALIGNOF(void *) ? align : ALIGNOF(void *)};
+    pool->slot_size = round_up(
+        object_size > SIZEOF(void *) ? object_size : SIZEOF(void *),
+        pool->align);
+    const size page_size = first_slot(pool) + pool->slot_size;
+    pool->page_size = round_up(page_size > HELLOC_POOL_PAGE_SIZE
+                                   ? page_size
+                                   : HELLOC_POOL_PAGE_SIZE,
+                               page_align(pool));
+    pool->id = atomic_fetch_add(&g_next_pool_id, 1);
+    if (pthread_mutex_init(&pool->lock, nullptr) != 0) {
+        return E_MEMORY_ALLOCATION_FAILED;
+    }
+    return E_SUCCESS;
+}
+
+void helloc_pool_free(HellocPool *pool) {
+    if (pool == nullptr) {
+        return;
+    }
+    // The magazines belong to their threads, which free them when they
+    // rebuild their tables or exit.  Until then, they only cost memory.
+    pthread_mutex_lock(&g_orphan_lock);
+    for (HellocPoolMagazine *m = pool->magazines; m != nullptr; m = m->next) {
+        m->pool = nullptr;
+    }
+    pthread_mutex_unlock(&g_orphan_lock);
+    if (t_last_pool_id == pool->id) {
+        t_last_pool_id = 0;
+        t_last_magazine = nullptr;
+    }
+    // The calling thread drops its own magazine right away.
+    if (t_table != nullptr && t_table->len > 0) {
+        table_rebuild(t_table);
+    }
+    HellocPoolPage *page = pool->pages;
+    while (page != nullptr) {
+        HellocPoolPage *next = page->next;
+        free(page);
+        page = next;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    *pool = (HellocPool){0};
+}
+
+void *helloc_pool_alloc(HellocPool *pool) {
+    HellocPoolMagazine *m = magazine(pool);
+    if (m != nullptr && m->count > 0) {
+        const size n = m->count - 1;
+        set_count(m, n);
+        return m->slots[n];
+    }
+    return alloc_slow(pool, m);
+}
+
+void helloc_pool_release(HellocPool *pool, void *obj) {
+    if (obj == nullptr) {
+        return;
+    }
+    HellocPoolMagazine *m = magazine(pool);
+    if (m != nullptr && m->count < HELLOC_POOL_MAGAZINE_SIZE) {
+        m->slots[m->count] = obj;
+        set_count(m, m->count + 1);
+        return;
+    }
+    release_slow(pool, m, obj);
+}
+
+void helloc_pool_reset(HellocPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    for (HellocPoolMagazine *m = pool->magazines; m != nullptr; m = m->next) {
+        set_count(m, 0);
+    }
+    pool->free_list = nullptr;
+    pool->free_count = 0;
+    pool->carved = 0;
+    pool->carve_page = nullptr;
+    pool->carve_next = nullptr;
+    pool->carve_end = nullptr;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void helloc_pool_stats(HellocPool *pool, HellocPoolStats *stats) {
+    pthread_mutex_lock(&pool->lock);
+    size cached = 0;
+    for (HellocPoolMagazine *m = pool->magazines; m != nullptr; m = m->next) {
+        cached += __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+    }
+    const size per_page =
+        (pool->page_size - first_slot(pool)) / pool->slot_size;
+    *stats = (HellocPoolStats){
+        .slot_size = pool->slot_size,
+        .pages = pool->page_count,
+        .capacity = pool->page_count * per_page,
+        .in_use = pool->carved - pool->free_count - cached,
+        .cached = cached,
+        .reserved_bytes = pool->page_count * pool->page_size,
+    };
+    pthread_mutex_unlock(&pool->lock);
+}
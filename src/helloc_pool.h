@@ -0,0 +1,157 @@
+/// @file helloc_pool.h
+/// @brief Provides a pool allocator for objects of one size.
+///
+/// The pool carves pages of HELLOC_POOL_PAGE_SIZE bytes into equal slots.
+/// Released slots are kept in an intrusive free list, i.e., the link to the
+/// next free slot is stored in the slot itself, so there is no per-object
+/// overhead.
+///
+/// Each thread caches up to HELLOC_POOL_MAGAZINE_SIZE free slots of a pool
+/// in its own magazine.  helloc_pool_alloc() and helloc_pool_release() only
+/// take the lock of the pool when the magazine of the calling thread is
+/// empty or full, and then move half a magazine at once, so threads rarely
+/// contend.
+///
+/// All pools share one thread-local key, so any number of pools can exist.
+/// A magazine costs about `HELLOC_POOL_MAGAZINE_SIZE * sizeof(void *)`
+/// bytes for each pair of a thread and a pool that it used.  When a pool is
+/// freed, the magazines of other threads are freed lazily, when these
+/// threads add magazines for further pools or exit.
+///
+/// helloc_pool_reset() releases all objects at once, without visiting them,
+/// and keeps the pages for reuse.
+///
+/// Example:
+///
+/// ```
+/// HellocPool pool;
+/// helloc_pool_init(&pool, SIZEOF(Node), ALIGNOF(Node));
+/// Node *node = helloc_pool_alloc(&pool);
+/// ...
+/// helloc_pool_release(&pool, node);
+/// helloc_pool_free(&pool);
+/// ```
+
+// Inclusion guard
+#ifndef HELLOC_POOL_H
+#define HELLOC_POOL_H
+
+#include <pthread.h>
+
+#include "helloc.h"
+
+/// Size of the pages that are carved into slots, unless a slot is larger.
+#define HELLOC_POOL_PAGE_SIZE (64 * 1024)
+/// Maximum number of free slots that a thread caches per pool.
+#define HELLOC_POOL_MAGAZINE_SIZE 64
+
+/// A page of a HellocPool.  Defined in helloc_pool.c.
+typedef struct HellocPoolPage HellocPoolPage;
+/// The free slots of a HellocPool that a thread caches.  Defined in
+/// helloc_pool.c.
+typedef struct HellocPoolMagazine HellocPoolMagazine;
+
+/// @brief A pool allocator for objects of one size.
+///
+/// Create with helloc_pool_init().  The fields are guarded by `lock`.
+typedef struct {
+    /// The size of the slots, i.e., the object size rounded up to the
+    /// alignment and to the size of a pointer.
+    size slot_size;
+    size align;
+    size page_size;
+    /// Identifies the pool in the thread-local magazine cache.
+    u64 id;
+    pthread_mutex_t lock;
+    /// All magazines, for helloc_pool_reset() and helloc_pool_free().
+    HellocPoolMagazine *magazines;
+    /// All pages in allocation order.  Slots are carved from `carve_page`
+    /// at `carve_next`, and the pages after it are still empty.
+    HellocPoolPage *pages;
+    HellocPoolPage *last_page;
+    HellocPoolPage *carve_page;
+    u8 *carve_next;
+    u8 *carve_end;
+    /// The free list of slots that are not in a magazine.
+    void *free_list;
+    size free_count;
+    size page_count;
+    size carved;
+} HellocPool;
+
+/// @brief Describes the occupancy of a pool.
+///
+/// While other threads use the pool, the values are only approximate.
+typedef struct {
+    size slot_size;
+    size pages;
+    /// Total number of slots in all pages.
+    size capacity;
+    /// Number of allocated objects that were not released.
+    size in_use;
+    /// Number of free slots in the magazines of the threads.
+    size cached;
+    /// Total number of bytes of all pages.
+    size reserved_bytes;
+} HellocPoolStats;
+
+/// @brief Initializes a pool.
+///
+/// @param[out] pool The pool to initialize.  Must not be NULL.
+/// @param[in] object_size The size of the objects.
+/// @param[in] align The alignment of the objects, a power of two.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if pool is NULL, object_size is not positive, or
+/// align is not a power of two.
+/// @returns E_MEMORY_ALLOCATION_FAILED if the lock could not be created.
+Result helloc_pool_init(HellocPool *pool, size object_size, size align);
+
+/// @brief Releases all memory of the pool, including all objects.
+///
+/// No other thread may use the pool during or after the call.
+///
+/// @param[in,out] pool The pool to free.  NULL is a no-op.
+void helloc_pool_free(HellocPool *pool);
+
+/// @brief Allocates an object.
+///
+/// @param[in,out] pool The pool.  Must not be NULL.
+///
+/// @returns The uninitialized object, or NULL if the memory is exhausted.
+void *helloc_pool_alloc(HellocPool *pool);
+
+/// @brief Releases an object that was allocated from the same pool by any
+/// thread.
+///
+/// @param[in,out] pool The pool.  Must not be NULL.
+/// @param[in] obj The object to release.  NULL is a no-op.
+void helloc_pool_release(HellocPool *pool, void *obj);
+
+/// @brief Releases all objects of the pool at once.
+///
+/// The pages are kept and reused by later allocations.  No other thread may
+/// use the pool during the call.
+///
+/// @param[in,out] pool The pool.  Must not be NULL.
+void helloc_pool_reset(HellocPool *pool);
+
+/// @brief Reports the occupancy of the pool.
+///
+/// @param[in,out] pool The pool.  Must not be NULL.
+/// @param[out] stats Stores the occupancy.  Must not be NULL.
+void helloc_pool_stats(HellocPool *pool, HellocPoolStats *stats);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define pool_init helloc_pool_init
+#define pool_free helloc_pool_free
+#define pool_alloc helloc_pool_alloc
+#define pool_release helloc_pool_release
+#define pool_reset helloc_pool_reset
+#define pool_stats helloc_pool_stats
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_POOL_H
@@ -0,0 +1,255 @@
+/// @file helloc_ulist.c
+/// @brief Implementation of the unrolled list.
+
+#include "helloc_ulist.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helloc.h"
+
+static HellocUListNode *node_new(void) {
+    HellocUListNode *n =
+        aligned_alloc(HELLOC_CACHE_LINE_SIZE, sizeof(HellocUListNode));
+    if (n != nullptr) {
+        n->next = nullptr;
+        n->prev = nullptr;
+        n->count = 0;
+    }
+    return n;
+}
+
+// Links node n into the list right after `at`, or as the new head if `at` is
+// NULL.
+static void link_after(HellocUList *l, HellocUListNode *at,
+                       HellocUListNode *n) {
+    n->prev = at;
+    n->next = at != nullptr ? at->next : l->head;
+    if (n->next != nullptr) {
+        n->next->prev = n;
+    } else {
+        l->tail = n;
+    }
+    if (at != nullptr) {
+        at->next = n;
+    } else {
+        l->head = n;
+    }
+}
+
+static void unlink_node(HellocUList *l, HellocUListNode *n) {
+    if (n->prev != nullptr) {
+        n->prev->next = n->next;
+    } else {
+        l->head = n->next;
+    }
+    if (n->next != nullptr) {
+        n->next->prev = n->prev;
+    } else {
+        l->tail = n->prev;
+    }
+}
+
+// Finds the node that holds the item at position index, which must be in the
+// range [0, l->len), and stores the position within that node in *offset.
+// Walks from whichever end of the list is closer.
+static HellocUListNode *locate(const HellocUList *l, size index,
+                               size *offset) {
+    HellocUListNode *n = nullptr;
+    if (index < l->len / 2) {
+        n = l->head;
+        while (index >= n->count) {
+            index -= n->count;
+            n = n->next;
+        }
+    } else {
+        size remaining = l->len - index; // in the range [1, l->len]
+        n = l->tail;
+        while (remaining > n->count) {
+            remaining -= n->count;
+            n = n->prev;
+        }
+        index = n->count - remaining;
+    }
+    *offset = index;
+    return n;
+}
+
+// Moves the items [at, n->count) of node n into a new node that is linked
+// right after n.
+static HellocUListNode *split(HellocUList *l, HellocUListNode *n, size at) {
+    HellocUListNode *m = node_new();
+    if (m == nullptr) {
+        return nullptr;
+    }
+    m->count = n->count - at;
+    memcpy(m->items, n->items + at, (size_t)m->count * sizeof(s8));
+    n->count = at;
+    link_after(l, n, m);
+    return m;
+}
+
+void helloc_ulist_init(HellocUList *l) {
+    l->head = nullptr;
+    l->tail = nullptr;
+    l->len = 0;
+}
+
+void helloc_ulist_free(HellocUList *l) {
+    if (l == nullptr) {
+        return;
+    }
+    HellocUListNode *n = l->head;
+    while (n != nullptr) {
+        HellocUListNode *next = n->next;
+        free(n);
+        n = next;
+    }
+    helloc_ulist_init(l);
+}
+
+Result helloc_ulist_append(HellocUList *l, s8 item) {
+    if (l == nullptr) {
+        return E_INVALID_INPUT;
+    }
+    HellocUListNode *n = l->tail;
+    if (n == nullptr || n->count == HELLOC_ULIST_NODE_ITEMS) {
+        n = node_new();
+        if (n == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        link_after(l, l->tail, n);
+    }
+    n->items[n->count++] = item;
+    l->len++;
+    return E_SUCCESS;
+}
+
+Result helloc_ulist_insert(HellocUList *l, size index, s8 item) {
+    if (l == nullptr || index < 0 || index > l->len) {
+        return E_INVALID_INPUT;
+    }
+    if (index == l->len) {
+        return helloc_ulist_append(l, item);
+    }
+    size offset = 0;
+    HellocUListNode *n = locate(l, index, &offset);
+    if (n->count == HELLOC_ULIST_NODE_ITEMS) {
+        const size half = HELLOC_ULIST_NODE_ITEMS / 2;
+        HellocUListNode *m = split(l, n, half);
+        if (m == nullptr) {
+            return E_MEMORY_ALLOCATION_FAILED;
+        }
+        if (offset > half) {
+            n = m;
+            offset -= half;
+        }
+    }
+    memmove(n->items + offset + 1, n->items + offset,
+            (size_t)(n->count - offset) * sizeof(s8));
+    n->items[offset] = item;
+    n->count++;
+    l->len++;
+    return E_SUCCESS;
+}
+
+Result helloc_ulist_splice(HellocUList *l, size index, HellocUList *other) {
+    if (l == nullptr || other == nullptr || l == other || index < 0 ||
+        index > l->len) {
+        return E_INVALID_INPUT;
+    }
+    if (other->head == nullptr) {
+        return E_SUCCESS;
+    }
+    // The chain of other's nodes goes between `before` and `after`.
+    HellocUListNode *before = l->tail;
+    HellocUListNode *after = nullptr;
+    if (index < l->len) {
+        size offset = 0;
+        HellocUListNode *n = locate(l, index, &offset);
+        if (offset == 0) {
+            before = n->prev;
+            after = n;
+        } else {
+            after = split(l, n, offset);
+            if (after == nullptr) {
+                return E_MEMORY_ALLOCATION_FAILED;
+            }
+            before = n;
+        }
+    }
+    other->head->prev = before;
+    other->tail->next = after;
+    if (before != nullptr) {
+        before->next = other->head;
+    } else {
+        l->head = other->head;
+    }
+    if (after != nullptr) {
+        after->prev = other->tail;
+    } else {
+        l->tail = other->tail;
+    }
+    l->len += other->len;
+    helloc_ulist_init(other);
+    return E_SUCCESS;
+}
+
+Result helloc_ulist_remove(HellocUList *l, size index, s8 *out) {
+    if (l == nullptr || index < 0 || index >= l->len) {
+        return E_INVALID_INPUT;
+    }
+    size offset = 0;
+    HellocUListNode *n = locate(l, index, &offset);
+    if (out != nullptr) {
+        *out = n->items[offset];
+    }
+    n->count--;
+    memmove(n->items + offset, n->items + offset + 1,
+            (size_t)(n->count - offset) * sizeof(s8));
+    l->len--;
+
+    if (n->count == 0) {
+        unlink_node(l, n);
+        free(n);
+        return E_SUCCESS;
+    }
+    // Keep nodes dense: merge the next node into this one while both fit
+    // into half a node, so that a later insert does not split right away.
+    HellocUListNode *next = n->next;
+    if (next != nullptr &&
+        n->count + next->count <= HELLOC_ULIST_NODE_ITEMS / 2) {
+        memcpy(n->items + n->count, next->items,
+               (size_t)next->count * sizeof(s8));
+        n->count += next->count;
+        unlink_node(l, next);
+        free(next);
+    }
+    return E_SUCCESS;
+}
+
+s8 *helloc_ulist_get(const HellocUList *l, size index) {
+    if (l == nullptr || index < 0 || index >= l->len) {
+        return nullptr;
+    }
+    size offset = 0;
+    HellocUListNode *n = locate(l, index, &offset);
+    return &n->items[offset];
+}
+
+HellocUListIter helloc_ulist_iter(const HellocUList *l) {
+    return (HellocUListIter){.node = l->head, .index = 0};
+}
+
+bool helloc_ulist_next(HellocUListIter *it, s8 *out) {
+    if (it->node == nullptr) {
+        return false;
+    }
+    *out = it->node->items[it->index++];
+    if (it->index == it->node->count) {
+        it->node = it->node->next;
+        it->index = 0;
+    }
+    return true;
+}
@@ -0,0 +1,184 @@
+/// @file helloc_ulist.h
+/// @brief Provides an unrolled list, a cache-friendly sequence of s8 strings.
+///
+/// An unrolled list is a doubly-linked list of nodes, where each node stores
+/// many items in a contiguous array instead of just one.  Compared to a
+/// classic linked list like `zpl_list`, a traversal only follows one pointer
+/// per node (i.e., per HELLOC_ULIST_NODE_ITEMS items) and otherwise reads
+/// adjacent memory.  Compared to a dynamic array like stb_ds' `arr*`,
+/// inserting into or splicing into the middle only moves the items of a single
+/// node.
+///
+/// The list stores s8 values, i.e. (pointer, length) pairs.  It does not own
+/// nor copy the string data that the items point to.
+
+// Inclusion guard
+#ifndef HELLOC_ULIST_H
+#define HELLOC_ULIST_H
+
+#include <stdbool.h>
+
+#include "helloc.h"
+
+/// Cache line size in bytes, to which list nodes are aligned.
+#define HELLOC_CACHE_LINE_SIZE 64
+
+/// Number of items per node.  Chosen such that a node is exactly 1 KiB, i.e.
+/// 16 cache lines: a 32-byte header plus 62 items of 16 bytes each.
+#define HELLOC_ULIST_NODE_ITEMS 62
+
+/// @brief A node of an unrolled list.
+typedef struct HellocUListNode {
+    _Alignas(HELLOC_CACHE_LINE_SIZE) struct HellocUListNode *next;
+    struct HellocUListNode *prev;
+    /// Number of used slots in `items`, in the range [1,
+    /// HELLOC_ULIST_NODE_ITEMS] for any node that is linked into a list.
+    size count;
+    s8 items[HELLOC_ULIST_NODE_ITEMS];
+} HellocUListNode;
+static_assert(sizeof(HellocUListNode) == 1024, "node must be exactly 1 KiB");
+
+/// @brief An unrolled list of s8 strings.
+///
+/// A zero-initialized HellocUList is a valid, empty list.
+typedef struct {
+    HellocUListNode *head;
+    HellocUListNode *tail;
+    /// Total number of items in the list.
+    size len;
+} HellocUList;
+
+/// @brief Iterator over the items of an unrolled list, see
+/// helloc_ulist_iter().
+typedef struct {
+    const HellocUListNode *node;
+    size index;
+} HellocUListIter;
+
+/// @brief Initializes an empty list.
+///
+/// @param[out] l The list to initialize.  Must not be NULL.
+void helloc_ulist_init(HellocUList *l);
+
+/// @brief Releases all nodes of the list and resets it to an empty list.
+///
+/// The string data that the items point to is not freed.
+///
+/// @param[in,out] l The list to free.  NULL is a no-op.
+void helloc_ulist_free(HellocUList *l);
+
+/// @brief Appends an item to the end of the list in O(1).
+///
+/// @param[in,out] l The list.  Must not be NULL.
+/// @param[in] item The item to append.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if l is NULL.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_ulist_append(HellocUList *l, s8 item);
+
+/// @brief Inserts an item at the given position.
+///
+/// Only the items of the node that contains the position are moved.  If that
+/// node is full, it is split in half first.
+///
+/// @param[in,out] l The list.  Must not be NULL.
+/// @param[in] index The position of the new item, in the range [0, l->len].
+/// @param[in] item The item to insert.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if l is NULL or index is out of range.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_ulist_insert(HellocUList *l, size index, s8 item);
+
+/// @brief Moves all items of another list into the list at the given
+/// position.
+///
+/// The nodes of `other` are relinked rather than copied, so the cost does not
+/// depend on the length of `other`.  At most one node of `l` is split.
+///
+/// Example:
+///
+/// ```
+/// // l is [a, b, c] and other is [x, y]
+/// Result res = helloc_ulist_splice(&l, 1, &other);
+/// // l is [a, x, y, b, c] and other is empty
+/// ```
+///
+/// @param[in,out] l The destination list.  Must not be NULL.
+/// @param[in] index The position at which to insert, in the range [0, l->len].
+/// @param[in,out] other The source list, which is empty afterwards.  Must not
+/// be NULL and must not be the same list as l.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if l or other is NULL, if they are the same list,
+/// or if index is out of range.
+/// @returns E_MEMORY_ALLOCATION_FAILED
+Result helloc_ulist_splice(HellocUList *l, size index, HellocUList *other);
+
+/// @brief Removes the item at the given position.
+///
+/// @param[in,out] l The list.  Must not be NULL.
+/// @param[in] index The position of the item, in the range [0, l->len).
+/// @param[out] out Stores the removed item.  May be NULL.
+///
+/// @returns E_SUCCESS if successful.
+/// @returns E_INVALID_INPUT if l is NULL or index is out of range.
+Result helloc_ulist_remove(HellocUList *l, size index, s8 *out);
+
+/// @brief Returns a pointer to the item at the given position.
+///
+/// The pointer is invalidated by any subsequent modification of the list.
+///
+/// @returns A pointer to the item.
+/// @returns NULL if l is NULL or index is out of range [0, l->len).
+s8 *helloc_ulist_get(const HellocUList *l, size index);
+
+/// @brief Returns an iterator positioned before the first item of the list.
+///
+/// Example:
+///
+/// ```
+/// HellocUListIter it = helloc_ulist_iter(&l);
+/// s8 item;
+/// while (helloc_ulist_next(&it, &item)) {
+///     // ...do something with `item`...
+/// }
+/// ```
+///
+/// Hot loops can also walk the nodes directly, which lets the compiler
+/// vectorize the inner loop:
+///
+/// ```
+/// for (const HellocUListNode *n = l.head; n != nullptr; n = n->next) {
+///     for (size i = 0; i < n->count; i++) {
+///         // ...do something with `n->items[i]`...
+///     }
+/// }
+/// ```
+HellocUListIter helloc_ulist_iter(const HellocUList *l);
+
+/// @brief Advances the iterator.
+///
+/// @param[in,out] it The iterator.  Must not be NULL.
+/// @param[out] out Stores the next item.  Must not be NULL.
+///
+/// @returns true if an item was stored in out, false at the end of the list.
+bool helloc_ulist_next(HellocUListIter *it, s8 *out);
+
+// Short names for the library API
+#ifdef HELLOC_SHORT_NAMES
+// NOLINTBEGIN(readability-identifier-naming)
+#define ulist_init helloc_ulist_init
+#define ulist_free helloc_ulist_free
+#define ulist_append helloc_ulist_append
+#define ulist_insert helloc_ulist_insert
+#define ulist_splice helloc_ulist_splice
+#define ulist_remove helloc_ulist_remove
+#define ulist_get helloc_ulist_get
+#define ulist_iter helloc_ulist_iter
+#define ulist_next helloc_ulist_next
+// NOLINTEND(readability-identifier-naming)
+#endif // HELLOC_SHORT_NAMES
+
+#endif // HELLOC_ULIST_H
@@ -0,0 +1,61 @@
+/// @file malloc_trace_workload.c
+/// @brief Allocation workload for the malloc-trace test in unity_tests.c.
+///
+/// Runs under `LD_PRELOAD=libmalloc-trace.so`.  The threads swap allocations
+/// through shared slots, so memory that one thread frees or reallocates is
+/// often reused by another one, which is where the order of the trace
+/// records matters.  Built without sanitizers, because their runtimes must
+/// come first in the list of preloaded libraries.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum { THREADS = 4, SLOTS = 256, OPS_PER_THREAD = 200000 };
+
+static _Atomic(void *) g_slots[SLOTS];
+
+static uint64_t next_rand(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void *churn(void *arg) {
+    uint64_t state = (uint64_t)(uintptr_t)arg;
+    for (int i = 0; i < OPS_PER_THREAD; i++) {
+        const uint64_t r = next_rand(&state);
+        const size_t n = 16 + (size_t)((r >> 8) % 256);
+        _Atomic(void *) *slot = &g_slots[r % SLOTS];
+        if ((r >> 16) % 4 == 0) {
+            void *p = atomic_exchange(slot, nullptr);
+            void *q = realloc(p, n);
+            if (q == nullptr) {
+                q = p;
+            }
+            free(atomic_exchange(slot, q));
+        } else {
+            free(atomic_exchange(slot, malloc(n)));
+        }
+    }
+    return nullptr;
+}
+
+int main(void) {
+    pthread_t tids[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        if (pthread_create(&tids[i], nullptr, churn,
+                           (void *)(uintptr_t)(i + 1)) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(tids[i], nullptr);
+    }
+    for (int i = 0; i < SLOTS; i++) {
+        free(atomic_load(&g_slots[i]));
+    }
+    return EXIT_SUCCESS;
+}
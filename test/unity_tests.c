@@ -5,18 +5,38 @@
 /// which is installed in this project by manually copying a Unity release (C
 /// and header files) into the top-level `external/` folder.
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Allows us to use shortened names of functions in helloc.h in addition to
 // their long, prefixed names.
 #define HELLOC_SHORT_NAMES
 
 #include "helloc.h"
+#include "helloc_arena.h"
+#include "helloc_builder.h"
+#include "helloc_ingest.h"
+#include "helloc_map.h"
+#include "helloc_parser.h"
+#include "helloc_pool.h"
+#include "helloc_ulist.h"
 #include "unity.h"
 
+#ifdef MALLOC_TRACE_SHIM
+#include "malloc-trace.h"
+#endif
+
 void setUp(void) {
     // set stuff up here
 }
@@ -124,6 +144,49 @@ void verify_helloc_str_split_once(void) {
     TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, res);
 }
 
+void verify_helloc_s8_split_once(void) {
+    s8 left;
+    s8 right;
+    TEST_ASSERT_TRUE(s8_split_once(s8("foo:bar"), ':', &left, &right));
+    TEST_ASSERT_EQUAL_INT(3, left.len);
+    TEST_ASSERT_EQUAL_MEMORY("foo", left.data, 3);
+    TEST_ASSERT_EQUAL_INT(3, right.len);
+    TEST_ASSERT_EQUAL_MEMORY("bar", right.data, 3);
+
+    // Splits at the first delimiter only.
+    TEST_ASSERT_TRUE(s8_split_once(s8("::"), ':', &left, &right));
+    TEST_ASSERT_EQUAL_INT(0, left.len);
+    TEST_ASSERT_EQUAL_INT(1, right.len);
+    TEST_ASSERT_EQUAL_MEMORY(":", right.data, 1);
+
+    const s8 s = s8("foo");
+    TEST_ASSERT_FALSE(s8_split_once(s, ':', &left, &right));
+    TEST_ASSERT_EQUAL_PTR(s.data, left.data);
+    TEST_ASSERT_EQUAL_INT(3, left.len);
+    TEST_ASSERT_NULL(right.data);
+    TEST_ASSERT_EQUAL_INT(0, right.len);
+
+    TEST_ASSERT_FALSE(s8_split_once((s8){0}, ':', &left, &right));
+    TEST_ASSERT_EQUAL_INT(0, left.len);
+
+    // The delimiter at every position of a string that is searched 8 bytes
+    // at a time.  ';' is ':' ^ 1, which the word-wise search may report as a
+    // false positive after the delimiter.
+    u8 buf[27];
+    for (size pos = 0; pos < COUNTOF(buf); pos++) {
+        memset(buf, ';', sizeof(buf));
+        buf[pos] = ':';
+        TEST_ASSERT_TRUE(
+            s8_split_once((s8){buf, COUNTOF(buf)}, ':', &left, &right));
+        TEST_ASSERT_EQUAL_INT(pos, left.len);
+        TEST_ASSERT_EQUAL_PTR(buf + pos + 1, right.data);
+        TEST_ASSERT_EQUAL_INT(COUNTOF(buf) - pos - 1, right.len);
+    }
+    memset(buf, ';', sizeof(buf));
+    TEST_ASSERT_FALSE(
+        s8_split_once((s8){buf, COUNTOF(buf)}, ':', &left, &right));
+}
+
 void verify_helloc_str_trim(void) {
     char *s = "   foo ";
     char *expected = "foo";
@@ -180,6 +243,775 @@ void verify_helloc_str_trim(void) {
     TEST_ASSERT_EQUAL_size_t(0, actual_len);
 }
 
+// Fills the list with the items "0", "1", ..., up to n - 1 (mod 10).
+static void fill_ulist(HellocUList *l, size n) {
+    static const char *digits = "0123456789";
+    for (size i = 0; i < n; i++) {
+        s8 item = {(u8 *)(digits + (i % 10)), 1};
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_append(l, item));
+    }
+}
+
+void verify_helloc_ulist_append_and_iterate(void) {
+    HellocUList l;
+    ulist_init(&l);
+    TEST_ASSERT_NULL(ulist_get(&l, 0));
+
+    // Spans several nodes.
+    const size n = (3 * HELLOC_ULIST_NODE_ITEMS) + 5;
+    fill_ulist(&l, n);
+    TEST_ASSERT_EQUAL_INT64(n, l.len);
+    TEST_ASSERT_EQUAL_UINT64(0, (uptr)l.head % HELLOC_CACHE_LINE_SIZE);
+
+    HellocUListIter it = ulist_iter(&l);
+    s8 item = {0};
+    size i = 0;
+    while (ulist_next(&it, &item)) {
+        TEST_ASSERT_EQUAL_INT64(1, item.len);
+        TEST_ASSERT_EQUAL_CHAR('0' + (i % 10), item.data[0]);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_INT64(n, i);
+    TEST_ASSERT_EQUAL_CHAR('0' + ((n - 1) % 10),
+                           ulist_get(&l, n - 1)->data[0]);
+    TEST_ASSERT_NULL(ulist_get(&l, n));
+    TEST_ASSERT_NULL(ulist_get(&l, -1));
+
+    ulist_free(&l);
+    TEST_ASSERT_NULL(l.head);
+    TEST_ASSERT_EQUAL_INT64(0, l.len);
+}
+
+void verify_helloc_ulist_insert_and_remove(void) {
+    HellocUList l;
+    ulist_init(&l);
+    // Exactly one full node, so that the insert below must split it.
+    fill_ulist(&l, HELLOC_ULIST_NODE_ITEMS);
+
+    s8 x = s8("x");
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_insert(&l, 40, x));
+    TEST_ASSERT_EQUAL_INT64(HELLOC_ULIST_NODE_ITEMS + 1, l.len);
+    TEST_ASSERT_NOT_EQUAL(l.head, l.tail);
+    TEST_ASSERT_EQUAL_CHAR('9', ulist_get(&l, 39)->data[0]);
+    TEST_ASSERT_EQUAL_CHAR('x', ulist_get(&l, 40)->data[0]);
+    TEST_ASSERT_EQUAL_CHAR('0', ulist_get(&l, 41)->data[0]);
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_insert(&l, 0, x));
+    TEST_ASSERT_EQUAL_CHAR('x', ulist_get(&l, 0)->data[0]);
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, ulist_insert(&l, l.len + 1, x));
+
+    s8 removed = {0};
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_remove(&l, 41, &removed));
+    TEST_ASSERT_EQUAL_CHAR('x', removed.data[0]);
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_remove(&l, 0, &removed));
+    TEST_ASSERT_EQUAL_CHAR('x', removed.data[0]);
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, ulist_remove(&l, l.len, nullptr));
+
+    // Removing everything releases all nodes.
+    while (l.len > 0) {
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_remove(&l, l.len / 2, nullptr));
+    }
+    TEST_ASSERT_NULL(l.head);
+    TEST_ASSERT_NULL(l.tail);
+    ulist_free(&l);
+}
+
+void verify_helloc_ulist_splice(void) {
+    HellocUList l;
+    HellocUList other;
+    ulist_init(&l);
+    ulist_init(&other);
+    fill_ulist(&l, 10);
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_append(&other, s8("x")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_append(&other, s8("y")));
+
+    // Splice into the middle of a node, which splits that node.
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_splice(&l, 3, &other));
+    TEST_ASSERT_EQUAL_INT64(12, l.len);
+    TEST_ASSERT_NULL(other.head);
+    TEST_ASSERT_EQUAL_INT64(0, other.len);
+    const char *expected = "012xy3456789";
+    HellocUListIter it = ulist_iter(&l);
+    s8 item = {0};
+    size i = 0;
+    while (ulist_next(&it, &item)) {
+        TEST_ASSERT_EQUAL_CHAR(expected[i], item.data[0]);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_INT64(12, i);
+
+    // Splice at both ends.
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_append(&other, s8("a")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_splice(&l, 0, &other));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_append(&other, s8("z")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ulist_splice(&l, l.len, &other));
+    TEST_ASSERT_EQUAL_CHAR('a', ulist_get(&l, 0)->data[0]);
+    TEST_ASSERT_EQUAL_CHAR('z', ulist_get(&l, 13)->data[0]);
+    TEST_ASSERT_EQUAL_CHAR('z', l.tail->items[l.tail->count - 1].data[0]);
+
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, ulist_splice(&l, 0, &l));
+    ulist_free(&l);
+}
+
+void verify_helloc_map_put_get_remove(void) {
+    HellocMap m;
+    map_init(&m);
+    int a = 1;
+    int b = 2;
+    void *value = nullptr;
+    TEST_ASSERT_FALSE(map_get(&m, s8("missing"), &value));
+    TEST_ASSERT_FALSE(map_remove(&m, s8("missing"), nullptr));
+
+    // Short (inline), empty, and long (heap-allocated) keys
+    s8 short_key = s8("short");
+    s8 empty_key = {nullptr, 0};
+    s8 long_key = s8("a key that is longer than the inline key length");
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, map_put(&m, short_key, &a));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, map_put(&m, empty_key, &b));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, map_put(&m, long_key, &b));
+    TEST_ASSERT_EQUAL_INT64(3, map_len(&m));
+    TEST_ASSERT_TRUE(map_get(&m, short_key, &value));
+    TEST_ASSERT_EQUAL_PTR(&a, value);
+    TEST_ASSERT_TRUE(map_get(&m, empty_key, &value));
+    TEST_ASSERT_EQUAL_PTR(&b, value);
+    TEST_ASSERT_TRUE(map_get(&m, long_key, &value));
+    TEST_ASSERT_EQUAL_PTR(&b, value);
+    TEST_ASSERT_FALSE(map_get(&m, s8("shor"), nullptr));
+
+    // Keys are compared by content, not by pointer.
+    char buf[] = "short";
+    TEST_ASSERT_TRUE(map_get(&m, (s8){(u8 *)buf, 5}, &value));
+    TEST_ASSERT_EQUAL_PTR(&a, value);
+
+    // Updating an existing key does not add an entry.
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, map_put(&m, short_key, &b));
+    TEST_ASSERT_EQUAL_INT64(3, map_len(&m));
+    TEST_ASSERT_TRUE(map_get(&m, short_key, &value));
+    TEST_ASSERT_EQUAL_PTR(&b, value);
+
+    TEST_ASSERT_TRUE(map_remove(&m, long_key, &value));
+    TEST_ASSERT_EQUAL_PTR(&b, value);
+    TEST_ASSERT_FALSE(map_get(&m, long_key, nullptr));
+    TEST_ASSERT_EQUAL_INT64(2, map_len(&m));
+
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, map_put(nullptr, short_key, &a));
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT,
+                          map_put(&m, (s8){nullptr, 3}, &a));
+    map_free(&m);
+    TEST_ASSERT_EQUAL_INT64(0, map_len(&m));
+}
+
+void verify_helloc_map_incremental_resize(void) {
+    enum { N = 20000 };
+    static char keys[N][24];
+    HellocMap m;
+    map_init(&m);
+    for (size i = 0; i < N; i++) {
+        // Mix short and long keys.
+        if (i % 3 == 0) {
+            snprintf(keys[i], sizeof(keys[i]), "long-key-number-%td", i);
+        } else {
+            snprintf(keys[i], sizeof(keys[i]), "k%td", i);
+        }
+        s8 key = {(u8 *)keys[i], (size)strlen(keys[i])};
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, map_put(&m, key, keys[i]));
+        // Every key must remain reachable while entries are being moved.
+        if (i % 997 == 0) {
+            for (size j = 0; j <= i; j++) {
+                s8 k = {(u8 *)keys[j], (size)strlen(keys[j])};
+                TEST_ASSERT_TRUE(map_get(&m, k, nullptr));
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_INT64(N, map_len(&m));
+
+    // Remove every other key, then verify the rest.
+    for (size i = 0; i < N; i += 2) {
+        s8 key = {(u8 *)keys[i], (size)strlen(keys[i])};
+        void *value = nullptr;
+        TEST_ASSERT_TRUE(map_remove(&m, key, &value));
+        TEST_ASSERT_EQUAL_PTR(keys[i], value);
+    }
+    TEST_ASSERT_EQUAL_INT64(N / 2, map_len(&m));
+    for (size i = 0; i < N; i++) {
+        s8 key = {(u8 *)keys[i], (size)strlen(keys[i])};
+        TEST_ASSERT_EQUAL(i % 2 == 1, map_get(&m, key, nullptr));
+    }
+    map_free(&m);
+}
+
+void verify_helloc_arena_alloc(void) {
+    HellocArena a;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, arena_init(&a, 256));
+    u8 *c = NEW(&a, u8, 3);
+    i64 *n = NEW(&a, i64, 4);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_NOT_NULL(n);
+    TEST_ASSERT_EQUAL_INT(0, (uptr)n % ALIGNOF(i64));
+    TEST_ASSERT_EQUAL_INT64(0, n[3]);
+    // Exhausting the arena fails without changing it.
+    u8 *beg = a.beg;
+    TEST_ASSERT_NULL(NEW(&a, u8, 256));
+    TEST_ASSERT_EQUAL_PTR(beg, a.beg);
+    arena_free(&a);
+}
+
+void verify_helloc_builder_append(void) {
+    HellocBuilder b;
+    builder_init(&b, nullptr);
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("n=")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_i64(&b, 0));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8(",")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_i64(&b, -42));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8(",")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_i64(&b, INT64_MIN));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                          builder_appendf(&b, " %s|%5.1f", "pi", 3.14159));
+    s8 out;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_s8(&b, &out));
+    const char *expected = "n=0,-42,-9223372036854775808 pi|  3.1";
+    TEST_ASSERT_EQUAL_INT(strlen(expected), out.len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, out.data, out.len);
+
+    // Many appends, including a formatted piece longer than the capacity.
+    builder_reset(&b);
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("ab")));
+    }
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_appendf(&b, "%0500d", 7));
+    TEST_ASSERT_EQUAL_INT(2500, builder_len(&b));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_s8(&b, &out));
+    TEST_ASSERT_EQUAL_MEMORY("abab", out.data, 4);
+    TEST_ASSERT_EQUAL_MEMORY("0007", out.data + 2496, 4);
+    builder_free(&b);
+
+    // In an arena, the buffer grows in place while it is the most recent
+    // allocation.
+    HellocArena a;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, arena_init(&a, 4096));
+    builder_init(&b, &a);
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("0123456789")));
+    }
+    TEST_ASSERT_EQUAL_PTR(a.mem, b.buf);
+    TEST_ASSERT_EQUAL_INT(E_MEMORY_ALLOCATION_FAILED,
+                          builder_appendf(&b, "%4096d", 1));
+    TEST_ASSERT_EQUAL_INT(1000, builder_len(&b));
+    builder_free(&b);
+    arena_free(&a);
+}
+
+void verify_helloc_builder_flush(void) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    HellocBuilder b;
+    builder_init(&b, nullptr);
+    char big[1000];
+    memset(big, 'x', sizeof(big));
+    const s8 ref = {(u8 *)big, COUNTOF(big)};
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("head:")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_ref(&b, ref));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8(":")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_i64(&b, 12));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_ref(&b, s8(":tail")));
+    TEST_ASSERT_EQUAL_INT(5 + 1000 + 3 + 5, builder_len(&b));
+
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_flush(&b, fds[1]));
+    TEST_ASSERT_EQUAL_INT(0, builder_len(&b));
+    char got[2000];
+    TEST_ASSERT_EQUAL_INT(1013, read(fds[0], got, sizeof(got)));
+    TEST_ASSERT_EQUAL_MEMORY("head:", got, 5);
+    TEST_ASSERT_EQUAL_MEMORY(big, got + 5, sizeof(big));
+    TEST_ASSERT_EQUAL_MEMORY(":12:tail", got + 1005, 8);
+
+    // builder_s8() copies referenced pieces, so they are no longer needed.
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("<")));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append_ref(&b, ref));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8(">")));
+    s8 out;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_s8(&b, &out));
+    memset(big, 'y', sizeof(big));
+    TEST_ASSERT_EQUAL_INT(1002, out.len);
+    TEST_ASSERT_EQUAL_INT('<', out.data[0]);
+    TEST_ASSERT_EQUAL_INT('x', out.data[500]);
+    TEST_ASSERT_EQUAL_INT('>', out.data[1001]);
+
+    // A full non-blocking pipe fails the flush, which keeps the rest.
+    builder_reset(&b);
+    enum { CHUNK = 50000 };
+    u8 *expect = malloc(3 * CHUNK);
+    for (size i = 0; i < 3 * CHUNK; i++) {
+        expect[i] = (u8)(i % 251);
+    }
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                          builder_append(&b, (s8){expect, CHUNK}));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                          builder_append_ref(&b, (s8){expect + CHUNK, CHUNK}));
+    TEST_ASSERT_EQUAL_INT(
+        E_SUCCESS, builder_append(&b, (s8){expect + (2 * CHUNK), CHUNK}));
+    TEST_ASSERT_EQUAL_INT(
+        0, fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK));
+    u8 *read_back = malloc(3 * CHUNK);
+    size total = 0;
+    Result res;
+    while ((res = builder_flush(&b, fds[1])) != E_SUCCESS) {
+        TEST_ASSERT_EQUAL_INT(E_IO_FAILED, res);
+        TEST_ASSERT_EQUAL_INT(EAGAIN, errno);
+        const ssize_t n = read(fds[0], read_back + total,
+                               (size_t)((3 * CHUNK) - total));
+        TEST_ASSERT_TRUE(n > 0);
+        total += n;
+        TEST_ASSERT_EQUAL_INT((3 * CHUNK) - total, builder_len(&b));
+    }
+    while (total < 3 * CHUNK) {
+        const ssize_t n = read(fds[0], read_back + total,
+                               (size_t)((3 * CHUNK) - total));
+        TEST_ASSERT_TRUE(n > 0);
+        total += n;
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expect, read_back, 3 * CHUNK);
+    free(read_back);
+    free(expect);
+
+    builder_free(&b);
+    close(fds[0]);
+    close(fds[1]);
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_append(&b, s8("x")));
+    TEST_ASSERT_EQUAL_INT(E_IO_FAILED, builder_flush(&b, fds[1]));
+    TEST_ASSERT_EQUAL_INT(1, builder_len(&b));
+    builder_free(&b);
+}
+
+enum { INGEST_FILES = 5, INGEST_MAX_LEN = 512 };
+
+typedef struct {
+    char data[INGEST_FILES][INGEST_MAX_LEN];
+    size len[INGEST_FILES];
+    int eofs[INGEST_FILES];
+    int error[INGEST_FILES];
+    bool out_of_order;
+} IngestResult;
+
+static void collect_chunk(void *ctx, const HellocIngestChunk *chunk) {
+    IngestResult *r = ctx;
+    const size f = chunk->file;
+    r->out_of_order |= chunk->offset != r->len[f] || r->eofs[f] > 0 ||
+                       r->len[f] + chunk->data.len > INGEST_MAX_LEN;
+    if (!r->out_of_order && chunk->data.len > 0) {
+        memcpy(r->data[f] + r->len[f], chunk->data.data,
+               (size_t)chunk->data.len);
+    }
+    r->len[f] += chunk->data.len;
+    r->eofs[f] += chunk->eof;
+    r->error[f] = chunk->error;
+}
+
+void verify_helloc_ingest_files(void) {
+    // The last file does not exist.  With 100-byte buffers, the 300-byte
+    // file takes three full reads and an empty one.
+    const size lens[INGEST_FILES] = {0, 1, 100, 300, 0};
+    char names[INGEST_FILES][64];
+    const char *paths[INGEST_FILES];
+    char content[INGEST_MAX_LEN];
+    for (size i = 0; i < COUNTOF(content); i++) {
+        content[i] = (char)('a' + (i % 26));
+    }
+    for (int i = 0; i < INGEST_FILES; i++) {
+        snprintf(names[i], sizeof(names[i]), "/tmp/helloc_ingest_%d_%d",
+                 (int)getpid(), i);
+        paths[i] = names[i];
+        if (i < INGEST_FILES - 1) {
+            FILE *f = fopen(names[i], "wb");
+            TEST_ASSERT_NOT_NULL(f);
+            fwrite(content, 1, (size_t)lens[i], f);
+            fclose(f);
+        }
+    }
+
+    for (int force_pread = 0; force_pread <= 1; force_pread++) {
+        const HellocIngestOptions opts = {.queue_depth = 2,
+                                          .buffer_size = 100,
+                                          .force_pread = force_pread};
+        IngestResult *r = calloc(1, sizeof(*r));
+        HellocIngestStats stats;
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                              ingest_files(paths, INGEST_FILES, &opts,
+                                           collect_chunk, r, &stats));
+        if (force_pread) {
+            TEST_ASSERT_EQUAL_INT(HELLOC_INGEST_PREAD, stats.backend);
+        }
+        TEST_ASSERT_FALSE(r->out_of_order);
+        TEST_ASSERT_EQUAL_INT(1, stats.files_failed);
+        TEST_ASSERT_EQUAL_INT(401, stats.bytes);
+        for (int i = 0; i < INGEST_FILES; i++) {
+            TEST_ASSERT_EQUAL_INT(lens[i], r->len[i]);
+            if (lens[i] > 0) {
+                TEST_ASSERT_EQUAL_MEMORY(content, r->data[i],
+                                         (size_t)lens[i]);
+            }
+            TEST_ASSERT_EQUAL_INT(1, r->eofs[i]);
+        }
+        TEST_ASSERT_EQUAL_INT(0, r->error[3]);
+        TEST_ASSERT_EQUAL_INT(ENOENT, r->error[INGEST_FILES - 1]);
+        free(r);
+    }
+
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, ingest_files(paths, 0, nullptr,
+                                                  collect_chunk, nullptr,
+                                                  nullptr));
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, ingest_files(paths, 1, nullptr,
+                                                        nullptr, nullptr,
+                                                        nullptr));
+    for (int i = 0; i < INGEST_FILES - 1; i++) {
+        remove(names[i]);
+    }
+}
+
+// Appends "key=>value\n", or "key!\n" without a value, to a HellocBuilder.
+static void collect_record(void *ctx, const HellocRecord *record) {
+    HellocBuilder *b = ctx;
+    builder_append(b, record->key);
+    builder_append(b, record->has_value ? s8("=>") : s8("!"));
+    builder_append(b, record->value);
+    builder_append(b, s8("\n"));
+}
+
+// Parses the stream in two parts split at `at`, or in chunks of `step`
+// bytes if at < 0, and compares the records with the expected ones.
+static void parse_in_chunks(s8 stream, size at, size step, s8 expected) {
+    HellocBuilder b;
+    builder_init(&b, nullptr);
+    HellocParser p;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                          parser_init(&p, s8("\r\n"), '=', 16,
+                                      collect_record, &b));
+    if (at >= 0) {
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                              parser_feed(&p, (s8){stream.data, at}));
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                              parser_feed(&p, (s8){stream.data + at,
+                                                   stream.len - at}));
+    } else {
+        for (size i = 0; i < stream.len; i += step) {
+            const size n = stream.len - i < step ? stream.len - i : step;
+            TEST_ASSERT_EQUAL_INT(E_SUCCESS,
+                                  parser_feed(&p, (s8){stream.data + i, n}));
+        }
+    }
+    parser_finish(&p);
+    TEST_ASSERT_EQUAL_INT(6, p.records);
+    TEST_ASSERT_EQUAL_INT(1, p.dropped);
+    s8 got;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, builder_s8(&b, &got));
+    TEST_ASSERT_EQUAL_INT(expected.len, got.len);
+    TEST_ASSERT_EQUAL_MEMORY(expected.data, got.data, got.len);
+    parser_free(&p);
+    builder_free(&b);
+}
+
+void verify_helloc_parser_chunk_boundaries(void) {
+    // Records of up to 16 bytes, with an empty record, a record without a
+    // value, a lone "\r" within a record, a record that is too long, and a
+    // last record without a delimiter.
+    const s8 stream = s8("a=1\r\nbb=22\r\n\r\nnovalue\r\nk=v=w\r\n"
+                         "x=0123456789abcdefXYZ\r\nc=\r3\r\nlast=9");
+    const s8 expected =
+        s8("a=>1\nbb=>22\nnovalue!\nk=>v=w\nc=>\r3\nlast=>9\n");
+    for (size at = 0; at <= stream.len; at++) {
+        parse_in_chunks(stream, at, 0, expected);
+    }
+    for (size step = 1; step <= stream.len; step++) {
+        parse_in_chunks(stream, -1, step, expected);
+    }
+
+    HellocParser p;
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT,
+                          parser_init(&p, s8(""), '=', 0, collect_record,
+                                      nullptr));
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT,
+                          parser_init(&p, s8("\n"), '=', 0, nullptr,
+                                      nullptr));
+}
+
+enum { POOL_OBJECTS = 5000, POOL_THREADS = 4, POOL_ROUNDS = 2000 };
+
+// Allocates and releases batches of objects, and checks that no object is
+// handed out twice while it is in use.
+static void *pool_worker(void *arg) {
+    HellocPool *pool = arg;
+    u64 *objs[100];
+    for (int round = 0; round < POOL_ROUNDS; round++) {
+        for (int i = 0; i < 100; i++) {
+            objs[i] = pool_alloc(pool);
+            *objs[i] = ((u64)(uptr)objs + (u64)i);
+        }
+        for (int i = 0; i < 100; i++) {
+            if (*objs[i] != ((u64)(uptr)objs + (u64)i)) {
+                return arg;
+            }
+            pool_release(pool, objs[i]);
+        }
+    }
+    // Exit with objects in the magazine, which go back to the pool.
+    pool_release(pool, pool_alloc(pool));
+    return nullptr;
+}
+
+void verify_helloc_pool_alloc_release(void) {
+    HellocPool pool;
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, pool_init(&pool, 0, 8));
+    TEST_ASSERT_EQUAL_INT(E_INVALID_INPUT, pool_init(&pool, 24, 12));
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, pool_init(&pool, 40, 64));
+    void **objs = calloc(POOL_OBJECTS, sizeof(*objs));
+    for (int i = 0; i < POOL_OBJECTS; i++) {
+        objs[i] = pool_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(objs[i]);
+        TEST_ASSERT_EQUAL_INT(0, (uptr)objs[i] % 64);
+        memset(objs[i], i, 40);
+    }
+    HellocPoolStats stats;
+    pool_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_INT(64, stats.slot_size);
+    TEST_ASSERT_EQUAL_INT(POOL_OBJECTS, stats.in_use);
+    TEST_ASSERT_TRUE(stats.capacity >= POOL_OBJECTS);
+    TEST_ASSERT_EQUAL_INT(stats.pages * HELLOC_POOL_PAGE_SIZE,
+                          stats.reserved_bytes);
+    const size pages = stats.pages;
+    for (int i = 0; i < POOL_OBJECTS; i++) {
+        TEST_ASSERT_EQUAL_INT((u8)i, ((u8 *)objs[i])[39]);
+        pool_release(&pool, objs[i]);
+    }
+    pool_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.in_use);
+    TEST_ASSERT_TRUE(stats.cached <= HELLOC_POOL_MAGAZINE_SIZE);
+
+    // After a reset, the pages are reused.
+    for (int i = 0; i < POOL_OBJECTS; i++) {
+        objs[i] = pool_alloc(&pool);
+    }
+    pool_reset(&pool);
+    pool_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.in_use);
+    TEST_ASSERT_EQUAL_INT(0, stats.cached);
+    for (int i = 0; i < POOL_OBJECTS; i++) {
+        objs[i] = pool_alloc(&pool);
+    }
+    pool_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_INT(POOL_OBJECTS, stats.in_use);
+    TEST_ASSERT_EQUAL_INT(pages, stats.pages);
+    free(objs);
+    pool_free(&pool);
+
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, pool_init(&pool, 8, 8));
+    pthread_t threads[POOL_THREADS];
+    for (int i = 0; i < POOL_THREADS; i++) {
+        TEST_ASSERT_EQUAL_INT(
+            0, pthread_create(&threads[i], nullptr, pool_worker, &pool));
+    }
+    for (int i = 0; i < POOL_THREADS; i++) {
+        void *failed;
+        pthread_join(threads[i], &failed);
+        TEST_ASSERT_NULL(failed);
+    }
+    pool_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.in_use);
+    TEST_ASSERT_EQUAL_INT(0, stats.cached);
+    pool_free(&pool);
+}
+
+enum { MANY_POOLS = 1500 };
+
+typedef struct {
+    HellocPool *pool;
+    atomic_bool cached;
+    /// Held by the main thread until the pool is freed.
+    pthread_mutex_t freed;
+} PoolOrphanArgs;
+
+// Keeps objects in its magazine while the pool is freed, then exits.
+static void *pool_orphan_worker(void *arg) {
+    PoolOrphanArgs *args = arg;
+    pool_release(args->pool, pool_alloc(args->pool));
+    atomic_store(&args->cached, true);
+    pthread_mutex_lock(&args->freed);
+    pthread_mutex_unlock(&args->freed);
+    return nullptr;
+}
+
+void verify_helloc_pool_many_pools(void) {
+    // More pools than PTHREAD_KEYS_MAX, used alternately by one thread.
+    HellocPool *pools = calloc(MANY_POOLS, sizeof(*pools));
+    for (int i = 0; i < MANY_POOLS; i++) {
+        TEST_ASSERT_EQUAL_INT(E_SUCCESS, pool_init(&pools[i], 16, 8));
+    }
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < MANY_POOLS; i++) {
+            void *obj = pool_alloc(&pools[i]);
+            TEST_ASSERT_NOT_NULL(obj);
+            pool_release(&pools[i], obj);
+        }
+        // The entries of freed pools are dropped as new ones are added.
+        for (int i = round; i < MANY_POOLS; i += 3) {
+            pool_free(&pools[i]);
+            TEST_ASSERT_EQUAL_INT(E_SUCCESS, pool_init(&pools[i], 16, 8));
+        }
+    }
+    HellocPoolStats stats;
+    pool_stats(&pools[1], &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.in_use);
+    TEST_ASSERT_TRUE(stats.cached <= HELLOC_POOL_MAGAZINE_SIZE);
+    for (int i = 0; i < MANY_POOLS; i++) {
+        pool_free(&pools[i]);
+    }
+    free(pools);
+
+    // A thread that exits after its pool was freed frees its magazine.
+    HellocPool pool;
+    TEST_ASSERT_EQUAL_INT(E_SUCCESS, pool_init(&pool, 16, 8));
+    PoolOrphanArgs args = {.pool = &pool};
+    pthread_mutex_init(&args.freed, nullptr);
+    pthread_mutex_lock(&args.freed);
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(
+        0, pthread_create(&thread, nullptr, pool_orphan_worker, &args));
+    while (!atomic_load(&args.cached)) {
+        sched_yield();
+    }
+    pool_free(&pool);
+    memset(&pool, 0xAB, sizeof(pool));
+    pthread_mutex_unlock(&args.freed);
+    pthread_join(thread, nullptr);
+    pthread_mutex_destroy(&args.freed);
+}
+
+#ifdef MALLOC_TRACE_SHIM
+// Reads the next address of a malloc trace.  Returns false if truncated.
+static bool trace_next_addr(const u8 **p, const u8 *end, uint64_t *addr) {
+    uint64_t v = 0;
+    if (malloc_trace_get_varint(p, end, &v) != 0) {
+        return false;
+    }
+    *addr += (uint64_t)malloc_trace_unzigzag(v);
+    return true;
+}
+
+// Marks the address as allocated.  Returns false if it is allocated already,
+// i.e., if the trace records the allocation before the release.
+static bool trace_allocated(HellocMap *live, uint64_t addr) {
+    const s8 key = {(u8 *)&addr, SIZEOF(addr)};
+    return !map_get(live, key, nullptr) &&
+           map_put(live, key, nullptr) == E_SUCCESS;
+}
+
+static void trace_released(HellocMap *live, uint64_t addr) {
+    const s8 key = {(u8 *)&addr, SIZEOF(addr)};
+    map_remove(live, key, nullptr);
+}
+
+// Replays the records of a malloc trace.  Returns an error message, or NULL
+// if no address is allocated twice without a release in between.
+static const char *check_trace(const u8 *p, const u8 *end, size *ops) {
+    const char *const truncated = "truncated malloc trace";
+    const char *const twice = "address allocated twice without a free";
+    HellocMap live;
+    map_init(&live);
+    const char *err = nullptr;
+    uint64_t addr = 0;
+    while (p < end && err == nullptr) {
+        const u8 op = *p++;
+        uint64_t n = 0;
+        switch (op) {
+        case MALLOC_TRACE_MALLOC:
+        case MALLOC_TRACE_CALLOC:
+            if (malloc_trace_get_varint(&p, end, &n) != 0 ||
+                !trace_next_addr(&p, end, &addr)) {
+                err = truncated;
+            } else if (addr != 0 && !trace_allocated(&live, addr)) {
+                err = twice;
+            }
+            break;
+        case MALLOC_TRACE_REALLOC: {
+            if (!trace_next_addr(&p, end, &addr)) {
+                err = truncated;
+                break;
+            }
+            const uint64_t old = addr;
+            if (malloc_trace_get_varint(&p, end, &n) != 0 ||
+                !trace_next_addr(&p, end, &addr)) {
+                err = truncated;
+                break;
+            }
+            if (addr == 0 && n > 0) {
+                break; // failed, old is still allocated
+            }
+            if (old != 0) {
+                trace_released(&live, old);
+            }
+            if (addr != 0 && !trace_allocated(&live, addr)) {
+                err = twice;
+            }
+            break;
+        }
+        case MALLOC_TRACE_FREE:
+            if (!trace_next_addr(&p, end, &addr)) {
+                err = truncated;
+            } else {
+                trace_released(&live, addr);
+            }
+            break;
+        default:
+            err = "invalid op in malloc trace";
+        }
+        (*ops)++;
+    }
+    map_free(&live);
+    return err;
+}
+
+void verify_malloc_trace_order(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/helloc_malloc_trace_%d.trace",
+             (int)getpid());
+    char trace_env[128];
+    snprintf(trace_env, sizeof(trace_env), "%s=%s", MALLOC_TRACE_ENV, path);
+    char *const argv[] = {MALLOC_TRACE_WORKLOAD, nullptr};
+    char *const envp[] = {"LD_PRELOAD=" MALLOC_TRACE_SHIM, trace_env, nullptr};
+    fflush(stdout);
+    const pid_t pid = fork();
+    TEST_ASSERT_TRUE(pid >= 0);
+    if (pid == 0) {
+        execve(MALLOC_TRACE_WORKLOAD, argv, envp);
+        _exit(EXIT_FAILURE);
+    }
+    int status = 0;
+    TEST_ASSERT_EQUAL_INT(pid, waitpid(pid, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(EXIT_SUCCESS, WEXITSTATUS(status));
+
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    fseek(f, 0, SEEK_END);
+    const long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *buf = file_size > 0 ? malloc((size_t)file_size) : nullptr;
+    const bool read_ok =
+        buf != nullptr &&
+        fread(buf, 1, (size_t)file_size, f) == (size_t)file_size &&
+        file_size > (long)sizeof(MallocTraceHeader) &&
+        memcmp(buf, MALLOC_TRACE_MAGIC, 8) == 0;
+    fclose(f);
+    unlink(path);
+    size ops = 0;
+    const char *err =
+        read_ok ? check_trace(buf + sizeof(MallocTraceHeader),
+                              buf + file_size, &ops)
+                : "cannot read malloc trace";
+    free(buf);
+    TEST_ASSERT_NULL_MESSAGE(err, err);
+    // The workload makes 4 threads * 200000 allocations and frees.
+    TEST_ASSERT_TRUE(ops > 800000);
+}
+#endif // MALLOC_TRACE_SHIM
+
 int main(void) {
     // NOLINTBEGIN(misc-include-cleaner)
     UNITY_BEGIN();
@@ -188,7 +1020,23 @@ int main(void) {
     RUN_TEST(verify_sum);
     RUN_TEST(verify_helloc_str_dup);
     RUN_TEST(verify_helloc_str_split_once);
+    RUN_TEST(verify_helloc_s8_split_once);
     RUN_TEST(verify_helloc_str_trim);
+    RUN_TEST(verify_helloc_ulist_append_and_iterate);
+    RUN_TEST(verify_helloc_ulist_insert_and_remove);
+    RUN_TEST(verify_helloc_ulist_splice);
+    RUN_TEST(verify_helloc_map_put_get_remove);
+    RUN_TEST(verify_helloc_map_incremental_resize);
+    RUN_TEST(verify_helloc_arena_alloc);
+    RUN_TEST(verify_helloc_builder_append);
+    RUN_TEST(verify_helloc_builder_flush);
+    RUN_TEST(verify_helloc_ingest_files);
+    RUN_TEST(verify_helloc_parser_chunk_boundaries);
+    RUN_TEST(verify_helloc_pool_alloc_release);
+    RUN_TEST(verify_helloc_pool_many_pools);
+#ifdef MALLOC_TRACE_SHIM
+    RUN_TEST(verify_malloc_trace_order);
+#endif
     return UNITY_END();
     // NOLINTEND(misc-include-cleaner)
 }